@@ -0,0 +1,28 @@
+# - Try to find
+# Once done this will define
+#
+#  VORBISFILE_FOUND = VORBISFILE_FOUND - TRUE
+#  VORBISFILE_INCLUDE_DIR - include directory for Vorbisfile
+#  VORBISFILE_LIBRARY   - the library
+
+# first look in user defined locations
+find_path (VORBISFILE_INCLUDE_DIR
+  NAMES vorbis/vorbisfile.h
+  PATHS /usr/local/include/ /usr/include
+  ENV VORBISFILE_INC_DIR
+  )
+
+find_library(VORBISFILE_LIBRARY
+  NAMES vorbisfile
+  PATHS ENV LD_LIBRARY_PATH
+  ENV LIBRARY_PATH
+  /usr/local/lib
+  /usr/lib
+  ${VORBISFILE_INCLUDE_DIR}/../lib
+  ENV VORBISFILE_LIB_DIR
+  )
+
+if(VORBISFILE_LIBRARY AND VORBISFILE_INCLUDE_DIR)
+  set(VORBISFILE_FOUND TRUE)
+endif()
+
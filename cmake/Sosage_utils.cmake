@@ -12,12 +12,17 @@ set(CPACK_PACKAGE_EXECUTABLES "${SOSAGE_EXE_NAME};${SOSAGE_NAME}")
 set(CPACK_RESOURCE_FILE_LICENSE "${SOSAGE_DATA_FOLDER}/resources/LICENSE.md")
 
 set(CPACK_DEBIAN_PACKAGE_SECTION "games")
-set(CPACK_DEBIAN_PACKAGE_DEPENDS "libsdl2-2.0-0 (>=2.0.14), libsdl2-image-2.0-0, libsdl2-mixer-2.0-0, libsdl2-ttf-2.0-0, libyaml-0-2, liblz4-1")
+set(CPACK_DEBIAN_PACKAGE_DEPENDS "libsdl2-2.0-0 (>=2.0.18), libsdl2-image-2.0-0, libsdl2-mixer-2.0-0, libsdl2-ttf-2.0-0 (>=2.0.18), libyaml-0-2, liblz4-1")
 set(CPACK_DEBIAN_PACKAGE_HOMEPAGE ${SOSAGE_URL})
 
 set(CPACK_RPM_PACKAGE_GROUP "Games")
-set(CPACK_RPM_PACKAGE_REQUIRES "SDL2 >= 2.0.14, SDL2_image, SDL2_mixer, SDL2_ttf, libyaml, lz4-libs")
+set(CPACK_RPM_PACKAGE_REQUIRES "SDL2 >= 2.0.18, SDL2_image, SDL2_mixer, SDL2_ttf >= 2.0.18, libyaml, lz4-libs")
 set(CPACK_RPM_PACKAGE_URL ${SOSAGE_URL})
+
+if (VORBISFILE_FOUND)
+  set(CPACK_DEBIAN_PACKAGE_DEPENDS "${CPACK_DEBIAN_PACKAGE_DEPENDS}, libvorbisfile3")
+  set(CPACK_RPM_PACKAGE_REQUIRES "${CPACK_RPM_PACKAGE_REQUIRES}, libvorbis")
+endif()
 set(CPACK_RPM_EXCLUDE_FROM_AUTO_FILELIST_ADDITION /usr/share/icons /usr/share/icons/hicolor /usr/share/icons/hicolor/scalable /usr/share/icons/hicolor/scalable/apps /usr/share/applications)
 
 set(CPACK_NSIS_DISPLAY_NAME ${SOSAGE_NAME})
@@ -27,6 +27,8 @@
 #ifndef SOSAGE_COMPONENT_BASE_H
 #define SOSAGE_COMPONENT_BASE_H
 
+#include <Sosage/Utils/Symbol.h>
+
 #include <memory>
 #include <string>
 
@@ -37,7 +39,7 @@
 namespace Sosage::Component
 {
 
-using Id = std::pair<std::string, std::string>;
+using Id = std::pair<Symbol, Symbol>;
 
 class Base
 {
@@ -29,9 +29,11 @@
 
 #include <Sosage/Component/Base.h>
 #include <Sosage/Core/Graphic.h>
+#include <Sosage/Utils/Bitmap_2.h>
 #include <Sosage/Utils/geometry.h>
 #include <Sosage/Utils/graph.h>
 
+#include <array>
 #include <map>
 
 namespace Sosage
@@ -40,6 +42,7 @@ namespace Sosage
 namespace Config
 {
 constexpr double boundary_precision = 2.0;
+constexpr int ground_grid_cell_size = 32;
 } // namespace Config
 
 namespace Component
@@ -51,7 +54,6 @@ class Ground_map : public Base
   {
     Point point;
     unsigned char red = 0;
-    double dist = 0;
   };
 
   struct Edge
@@ -75,58 +77,134 @@ class Ground_map : public Base
     operator bool() const;
   };
 
-  struct Compare_ordered_pair
-  {
-    template <typename Pair>
-    Pair ordered (const Pair& p) const
-    {
-      if (p.first > p.second)
-        return Pair(p.second, p.first);
-      return p;
-    }
-    template <typename Pair>
-    bool operator() (const Pair& a, const Pair& b) const
-    {
-      return ordered(a) < ordered(b);
-    }
-  };
-
   const double snapping_dist = 5.;
-  Core::Graphic::Surface m_image;
+  // Map image is only kept as a ground mask plus a depth plane (red
+  // value of ground pixels), sampled without going through SDL
+  int m_width;
+  int m_height;
+  Bitmap_2 m_ground;
+  std::vector<unsigned char> m_depth;
   int m_radius;
   int m_front_z;
   int m_back_z;
   Graph m_graph;
-  Graph m_latest_graph;
+
+  // Uniform grid over border edges, segments are only tested against
+  // the borders stored in the cells they cross
+  int m_grid_width = 0;
+  int m_grid_height = 0;
+  std::vector<std::vector<GEdge> > m_grid;
+
+  // All-pairs shortest paths between base vertices, precomputed when
+  // packaging: row-major distances and next hop towards each target
+  static constexpr unsigned short no_next_hop = (unsigned short)(-1);
+  std::vector<float> m_distances;
+  std::vector<unsigned short> m_next_hops;
+
+  void build_grid();
+  template <typename Functor>
+  void for_each_cell (const Point& a, const Point& b, const Functor& functor) const;
+
+  // Temporary vertices and edges of the latest path query, layered on
+  // top of m_graph which is left untouched once built. Endpoints
+  // that are not base vertices get the indices num_vertices() and
+  // num_vertices() + 1. Buffers are kept to be reused by next query.
+  struct Overlay
+  {
+    std::array<GVertex, 2> endpoints;
+    std::array<Point, 2> points;
+    std::array<GEdge, 2> hidden;
+    std::array<std::vector<GVertex>, 2> links;
+    std::vector<unsigned char> linked;
+    std::vector<double> dist;
+    std::vector<GVertex> parent;
+    std::vector<std::pair<double, GVertex> > todo;
+  };
+  Overlay m_overlay;
+
+  void reset_overlay();
+  GVertex add_overlay_vertex (std::size_t idx, const Point& point);
+  void add_overlay_edge (std::size_t idx, GVertex v);
+  bool is_overlay_vertex (GVertex v) const
+  {
+    return (v != Graph::null_vertex() && std::size_t(v) >= m_graph.num_vertices());
+  }
+  bool is_hidden (GEdge e) const
+  {
+    return (e == m_overlay.hidden[0] || e == m_overlay.hidden[1]);
+  }
+  const Point& point (GVertex v) const
+  {
+    if (is_overlay_vertex(v))
+      return m_overlay.points[std::size_t(v) - m_graph.num_vertices()];
+    return m_graph[v].point;
+  }
+
+  template <typename Functor>
+  void for_each_neighbor (GVertex v, const Functor& functor) const
+  {
+    if (!is_overlay_vertex(v))
+      for (GEdge e : m_graph.incident_edges(v))
+        if (!is_hidden(e))
+          functor (m_graph.other(e, v));
+    for (std::size_t i = 0; i < 2; ++ i)
+    {
+      if (m_overlay.linked[std::size_t(v)] & (1 << i))
+        functor (m_overlay.endpoints[i]);
+      if (v == m_overlay.endpoints[i])
+        for (GVertex n : m_overlay.links[i])
+          functor (n);
+    }
+  }
 
   GVertex add_vertex (std::map<Point, GVertex>& map_p2v,
                       const Point& p, const unsigned char& red);
+  void build_raster (const std::string& file_name);
   void build_graph (const std::function<void()>& callback);
+  bool is_ground (int x, int y) const
+  {
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+      return false;
+    return m_ground (std::size_t(x), std::size_t(y));
+  }
+  unsigned char depth (int x, int y) const
+  {
+    return m_depth[std::size_t(y) * std::size_t(m_width) + std::size_t(x)];
+  }
 
 public:
 
   Ground_map (const std::string& entity, const std::string& component,
               const std::string& file_name, int front_z, int back_z,
               const std::function<void()>& callback);
+  void precompute_shortest_paths();
   void write (const std::string& filename);
   void read (const std::string& filename);
 
   template <typename Functor>
   void for_each_vertex (const Functor& functor) const
   {
-    for (GVertex v : m_latest_graph.vertices())
-      functor (m_latest_graph[v].point);
+    for (GVertex v : m_graph.vertices())
+      functor (m_graph[v].point);
+    for (GVertex v : m_overlay.endpoints)
+      if (is_overlay_vertex(v))
+        functor (point(v));
   }
 
   template <typename Functor>
   void for_each_edge (const Functor& functor) const
   {
-    for (GEdge e : m_latest_graph.edges())
+    for (GEdge e : m_graph.edges())
     {
-      const Point& s = m_latest_graph[m_latest_graph.source(e)].point;
-      const Point& t = m_latest_graph[m_latest_graph.target(e)].point;
-      functor (s, t, m_latest_graph[e].border);
+      if (is_hidden(e))
+        continue;
+      const Point& s = m_graph[m_graph.source(e)].point;
+      const Point& t = m_graph[m_graph.target(e)].point;
+      functor (s, t, m_graph[e].border);
     }
+    for (std::size_t i = 0; i < 2; ++ i)
+      for (GVertex n : m_overlay.links[i])
+        functor (point(m_overlay.endpoints[i]), point(n), false);
   }
 
   void find_path (Point origin, Point target, std::vector<Point>& out);
@@ -136,11 +214,13 @@ public:
   bool is_ground_point (const Point& p) const;
   Neighbor_query closest_simplex (const Point& p) const;
 
+  void dijkstra (GVertex vorigin);
   void shortest_path (GVertex vorigin, GVertex vtarget,
                       std::vector<Point>& out);
+  void precomputed_shortest_path (GVertex vorigin, GVertex vtarget,
+                                  std::vector<Point>& out);
 
-  bool intersects_border (const Graph& g,
-                          const Segment& seg,
+  bool intersects_border (const Segment& seg,
                           const Edge_condition& condition) const;
 
   Neighbor_query closest_intersected_edge (const Point& p, const Sosage::Vector& direction,
@@ -29,6 +29,7 @@
 
 #include <Sosage/Component/Base.h>
 
+#include <algorithm>
 #include <unordered_map>
 #include <vector>
 
@@ -39,16 +40,156 @@ struct Id_hash
 {
   std::size_t operator() (const Id& id) const
   {
-    return std::hash<std::string>()(id.first) ^ std::hash<std::string>()(id.second);
+    return id.first.hash() ^ (id.second.hash() << 1);
+  }
+};
+
+// Components of a same kind are stored contiguously (sparse set): the
+// hash table only maps ids to indices, so iterating walks a vector
+// instead of hash buckets. Erased slots are left empty so that erasing
+// while iterating is safe, they are only compacted by explicit calls
+// to compact() when no iteration is ongoing (between frames).
+class Handle_map
+{
+public:
+
+  using value_type = std::pair<Id, Handle>;
+
+  // Iterators hold indices, so they stay valid if the vector grows
+  template <typename Vector, typename Value>
+  class Iterator
+  {
+    Vector* m_vector;
+    std::size_t m_index;
+
+    void skip_empty()
+    {
+      while (m_index < m_vector->size() && !(*m_vector)[m_index].second)
+        ++ m_index;
+    }
+
+  public:
+
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type   = std::ptrdiff_t;
+    using value_type        = Value;
+    using pointer           = Value*;
+    using reference         = Value&;
+
+    Iterator (Vector* vector = nullptr, std::size_t index = 0)
+      : m_vector (vector), m_index (index)
+    { if (m_vector) skip_empty(); }
+
+    reference operator*() const { return (*m_vector)[m_index]; }
+    pointer operator->() const { return &(*m_vector)[m_index]; }
+    Iterator& operator++() { ++ m_index; skip_empty(); return *this; }
+    Iterator operator++(int) { Iterator tmp = *this; ++(*this); return tmp; }
+    friend bool operator== (const Iterator& a, const Iterator& b)
+    { return a.index() == b.index(); };
+    friend bool operator!= (const Iterator& a, const Iterator& b)
+    { return a.index() != b.index(); };
+
+  private:
+
+    // Past-the-end is the current size, even if elements were added
+    std::size_t index() const { return std::min (m_index, m_vector->size()); }
+  };
+
+  using iterator = Iterator<std::vector<value_type>, value_type>;
+  using const_iterator = Iterator<const std::vector<value_type>, const value_type>;
+
+private:
+
+  std::vector<value_type> m_dense;
+  std::unordered_map<Id, std::size_t, Id_hash> m_sparse;
+  std::size_t m_nb_empty = 0;
+
+public:
+
+  iterator begin() { return iterator (&m_dense, 0); }
+  iterator end() { return iterator (&m_dense, std::size_t(-1)); }
+  const_iterator begin() const { return const_iterator (&m_dense, 0); }
+  const_iterator end() const { return const_iterator (&m_dense, std::size_t(-1)); }
+  std::size_t size() const { return m_sparse.size(); }
+  bool empty() const { return m_sparse.empty(); }
+
+  iterator find (const Id& id)
+  {
+    auto iter = m_sparse.find(id);
+    if (iter == m_sparse.end())
+      return end();
+    return iterator (&m_dense, iter->second);
+  }
+
+  const_iterator find (const Id& id) const
+  {
+    auto iter = m_sparse.find(id);
+    if (iter == m_sparse.end())
+      return end();
+    return const_iterator (&m_dense, iter->second);
+  }
+
+  void insert_or_assign (const Id& id, const Handle& handle)
+  {
+    auto iter = m_sparse.find(id);
+    if (iter != m_sparse.end())
+    {
+      m_dense[iter->second].second = handle;
+      return;
+    }
+    m_sparse.insert (std::make_pair (id, m_dense.size()));
+    m_dense.emplace_back (id, handle);
+  }
+
+  void insert (const value_type& value) { insert_or_assign (value.first, value.second); }
+
+  void erase (iterator iter)
+  {
+    m_sparse.erase (iter->first);
+    iter->second.reset();
+    ++ m_nb_empty;
+  }
+
+  void clear()
+  {
+    m_dense.clear();
+    m_sparse.clear();
+    m_nb_empty = 0;
+  }
+
+  void swap (Handle_map& other)
+  {
+    m_dense.swap (other.m_dense);
+    m_sparse.swap (other.m_sparse);
+    std::swap (m_nb_empty, other.m_nb_empty);
+  }
+
+  // Moves elements: must not be called while iterating
+  void compact()
+  {
+    if (m_nb_empty <= m_dense.size() / 2)
+      return;
+
+    std::size_t current = 0;
+    for (std::size_t i = 0; i < m_dense.size(); ++ i)
+      if (m_dense[i].second)
+      {
+        if (current != i)
+          m_dense[current] = std::move(m_dense[i]);
+        m_sparse[m_dense[current].first] = current;
+        ++ current;
+      }
+    m_dense.resize (current);
+    m_nb_empty = 0;
   }
 };
 
-using Handle_map = std::unordered_map<Id, Handle, Id_hash>;
 using Component_map = std::vector<Handle_map>;
 
 class Handle_set
 {
   Handle_map& m_map;
+  std::size_t& m_revision;
 
 public:
 
@@ -77,8 +218,8 @@ public:
 
   using const_iterator = iterator;
 
-  Handle_set (Handle_map& map) : m_map (map) { }
-  void clear() { m_map.clear(); }
+  Handle_set (Handle_map& map, std::size_t& revision) : m_map (map), m_revision (revision) { }
+  void clear() { ++ m_revision; m_map.clear(); }
   iterator begin() { return iterator(m_map.begin()); }
   iterator end() { return iterator(m_map.end()); }
   const_iterator begin() const { return iterator(m_map.begin()); }
@@ -66,7 +66,9 @@ public:
          Font_handle font, const std::string& color_str,
          const std::string& text, bool outlined = false);
   Image (const std::string& entity, const std::string& component, std::shared_ptr<Image> copy);
-  void compose_with (const std::shared_ptr<Image>& other);
+  Image (const std::string& entity, const std::string& component,
+         std::shared_ptr<Image> left, int w, int h, int r, int g, int b,
+         std::shared_ptr<Image> right);
   void set_relative_origin (double ratio_x, double ratio_y);
   const Core::Graphic::Image& core() const;
   const Point& origin() const;
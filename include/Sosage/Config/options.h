@@ -45,6 +45,12 @@
 #define SOSAGE_SDL_TIME
 #endif
 
+// Android assets live inside the APK and Emscripten uses a virtual
+// file system: packages are always loaded in RAM there
+#if defined(SOSAGE_CFG_MAP_PACKAGES) && !defined(__ANDROID__) && !defined(__EMSCRIPTEN__)
+#define SOSAGE_MAP_PACKAGES
+#endif
+
 #ifndef SOSAGE_PREF_PATH
 #define SOSAGE_PREF_PATH "ptilouk"
 #endif
@@ -46,8 +46,9 @@ class Content
 private:
 
   Component::Component_map m_data;
+  std::vector<std::size_t> m_revisions;
   std::array<Component::Handle, NUMBER_OF_KEYS> m_fast_access_components;
-  std::unordered_map<std::string, std::size_t> m_map_component;
+  std::unordered_map<Symbol, std::size_t, Symbol_hash> m_map_component;
 
 public:
 
@@ -59,16 +60,30 @@ public:
   std::size_t size() const;
   Component::Component_map::const_iterator begin() const;
   Component::Component_map::const_iterator end() const;
-  Component::Handle_set components (const std::string& s);
-  bool remove (const std::string& entity, const std::string& component, bool optional = false);
+  Component::Handle_set components (const Symbol& s);
+  bool remove (const Symbol& entity, const Symbol& component, bool optional = false);
   bool remove (Component::Handle handle, bool optional = false);
 
+  // Changes whenever a component is set or removed in the given set,
+  // so that systems can keep handles as long as it stays the same
+  std::size_t revision (const Symbol& component);
+
+  // Gives a kind of component its own storage if it was in the
+  // default one and returns its index: kinds stored separately can be
+  // accessed concurrently. Must not be called while systems run.
+  std::size_t reserve (const Symbol& component);
+
+  // Reclaims slots of removed components, must not be called while
+  // systems run as it invalidates iterators
+  void compact();
+
   template <typename T>
   void set (const std::shared_ptr<T>& t)
   {
     count_set_ptr();
-    Component::Handle_map& hmap = handle_map(t->component());
-    hmap.insert_or_assign (t->id(), t);
+    std::size_t idx = component_index(t->component());
+    ++ m_revisions[idx];
+    m_data[idx].insert_or_assign (t->id(), t);
   }
 
   template <typename T, typename ... Args>
@@ -81,7 +96,7 @@ public:
   }
 
   template <typename T, typename ... Args>
-  std::shared_ptr<T> get_or_set (const std::string& entity, const std::string& component, Args&& ... args)
+  std::shared_ptr<T> get_or_set (const Symbol& entity, const Symbol& component, Args&& ... args)
   {
     count_set_args();
     if (auto out = request<T>(entity, component))
@@ -90,7 +105,7 @@ public:
   }
 
   template <typename T>
-  std::shared_ptr<T> request (const std::string& entity, const std::string& component)
+  std::shared_ptr<T> request (const Symbol& entity, const Symbol& component)
   {
     count_access(entity, component);
     count_request();
@@ -104,13 +119,13 @@ public:
   }
 
   template <typename T>
-  typename T::const_reference value (const std::string& entity, const std::string& component)
+  typename T::const_reference value (const Symbol& entity, const Symbol& component)
   {
     return get<T>(entity, component)->value();
   }
 
   template <typename T>
-  typename T::value_type value (const std::string& entity, const std::string& component,
+  typename T::value_type value (const Symbol& entity, const Symbol& component,
                                 const typename T::value_type& default_value)
   {
     if (auto t = request<T>(entity, component))
@@ -119,11 +134,11 @@ public:
   }
 
   template <typename T>
-  std::shared_ptr<T> get (const std::string& entity, const std::string& component)
+  std::shared_ptr<T> get (const Symbol& entity, const Symbol& component)
   {
     count_get();
     std::shared_ptr<T> out = request<T>(entity, component);
-    check (out != std::shared_ptr<T>(), "Cannot find " + entity + ":" + component);
+    check (out != std::shared_ptr<T>(), "Cannot find " + entity.str() + ":" + component.str());
     return out;
   }
 
@@ -148,13 +163,14 @@ public:
     return Component::cast<T>(m_fast_access_components[std::size_t(fac)])->value();
   }
 
-  void emit (const std::string& entity, const std::string& component);
-  bool receive (const std::string& signal, const std::string& component);
-  bool signal (const std::string& entity, const std::string& component);
+  void emit (const Symbol& entity, const Symbol& component);
+  bool receive (const Symbol& signal, const Symbol& component);
+  bool signal (const Symbol& entity, const Symbol& component);
 
 private:
 
-  Component::Handle_map& handle_map (const std::string& s);
+  std::size_t component_index (const Symbol& s);
+  Component::Handle_map& handle_map (const Symbol& s);
 
   void count_set_ptr();
   void count_set_args();
@@ -162,11 +178,11 @@ private:
   void count_get();
 
 #ifdef SOSAGE_PROFILE
-  std::unordered_map<std::string, std::size_t> m_access_count;
-  void count_access (const std::string& entity, const std::string& component);
+  std::unordered_map<Component::Id, std::size_t, Component::Id_hash> m_access_count;
+  void count_access (const Symbol& entity, const Symbol& component);
   void display_access();
 #else
-  void count_access (const std::string&, const std::string&);
+  void count_access (const Symbol&, const Symbol&);
   void display_access ();
 #endif
 };
@@ -68,6 +68,9 @@ public:
   static void delete_music (const Music&) { }
   static void delete_sound (const Sound&) { }
 
+  static void clear_managers() { }
+  static void pin_new_resources (bool) { }
+
   void set_music_channels (std::size_t) { }
   void start_music (const Music&, int, double) {}
   void stop_music(const Music&, int) {}
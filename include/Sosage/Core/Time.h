@@ -57,6 +57,13 @@ public:
         (std::chrono::steady_clock::duration
          (std::chrono::milliseconds { d }));
   }
+
+  // High resolution time in seconds
+  static double precise_now()
+  {
+    return std::chrono::duration<double>
+        (std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
 };
 #endif
 } // namespace Sosage::Core
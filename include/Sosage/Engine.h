@@ -31,6 +31,11 @@
 #include <Sosage/System/Base.h>
 #include <Sosage/Utils/error.h>
 
+#include <atomic>
+#include <future>
+#include <memory>
+#include <vector>
+
 namespace Sosage
 {
 
@@ -39,6 +44,22 @@ class Engine
   Content m_content;
   std::vector<System::Handle> m_systems;
 
+  // Systems are started in order, but those that do not need the main
+  // thread are sent to workers: only later systems whose declared
+  // access conflicts with theirs wait for them
+  struct Scheduled_system
+  {
+    System::Handle system;
+    System::Access access;
+    std::vector<std::size_t> reads; // Storage indices in content
+    std::vector<std::size_t> writes;
+    std::vector<std::size_t> dependencies;
+    std::shared_ptr<std::atomic<bool> > claimed;
+    std::future<void> done;
+    bool pending = false;
+  };
+  std::vector<Scheduled_system> m_schedule;
+
   enum Input_mode { NORMAL, TEST_MOUSE, TEST_RANDOM };
   Input_mode m_input_mode = NORMAL;
 
@@ -52,6 +73,9 @@ public:
 private:
 
   void handle_cmdline_args (int argc, char** argv);
+  void run_systems();
+  void wait_for_system (Scheduled_system& s);
+  static bool conflict (const Scheduled_system& a, const Scheduled_system& b);
 };
 
 } // namespace Sosage
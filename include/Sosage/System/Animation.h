@@ -41,6 +41,7 @@ namespace Config
 constexpr int camera_limit_left = world_width / 4;
 constexpr int camera_limit_right = (3 * world_width) / 4;
 constexpr int character_speed = 34;
+constexpr std::size_t animation_max_catch_up = animation_fps; // 1 second
 } // namespace Config
 
 namespace System
@@ -63,29 +64,31 @@ public:
 
   bool run_loading();
 
-  void place_and_scale_character (const std::string& id);
-  void generate_random_idle_animation (const std::string& id, bool looking_right);
-  void generate_random_idle_head_animation (const std::string& id, bool looking_right);
-  void generate_random_idle_body_animation  (const std::string& id, bool looking_right);
+  void place_and_scale_character (const Symbol& id);
+  void generate_random_idle_animation (const Symbol& id, bool looking_right);
+  void generate_random_idle_head_animation (const Symbol& id, bool looking_right);
+  void generate_random_idle_body_animation  (const Symbol& id, bool looking_right);
 
 private:
 
   void run_gui_frame();
   void run_animation_frame();
+  void run_catch_up_frames (std::size_t nb_frames);
 
   void handle_character_lookat (bool in_new_room);
   void handle_animation_stops();
   bool handle_moves();
+  bool handle_paths();
   void handle_animation_starts();
   void handle_state_changes();
   void handle_characters_headmove (Component::Animation_handle anim);
   void trigger_step_sounds (Component::Animation_handle anim);
 
   bool compute_movement_from_path (Component::Path_handle path);
-  void set_move_animation (const std::string& id, const Vector& direction);
+  void set_move_animation (const Symbol& id, const Vector& direction);
 
-  void generate_random_mouth_animation (const std::string& id);
-  void generate_animation (const std::string& id, const std::string& anim);
+  void generate_random_mouth_animation (const Symbol& id);
+  void generate_animation (const Symbol& id, const std::string& anim);
 
   bool fade (double begin_time, double end_time, bool fadein);
 
@@ -31,12 +31,47 @@
 #include <Sosage/Component/Status.h>
 #include <Sosage/Content.h>
 
+#include <initializer_list>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace Sosage::System
 {
 
+// Component kinds that a system reads and writes in run(), used by
+// the engine to run systems that do not conflict concurrently. Signals
+// are components too: peeking at one is a read, while receiving it
+// consumes it and is thus a write. Nothing declared means the system
+// may access everything.
+struct Access
+{
+  std::vector<Symbol> reads;
+  std::vector<Symbol> writes;
+  bool everything = true;
+  bool main_thread = true;
+
+  void read (std::initializer_list<Symbol> components)
+  {
+    everything = false;
+    reads.insert (reads.end(), components);
+  }
+
+  void write (std::initializer_list<Symbol> components)
+  {
+    everything = false;
+    writes.insert (writes.end(), components);
+  }
+
+  void clear()
+  {
+    reads.clear();
+    writes.clear();
+    everything = true;
+    main_thread = true;
+  }
+};
+
 class Base
 {
 protected:
@@ -53,23 +88,25 @@ public:
   virtual ~Base();
   virtual void init();
   virtual void run() = 0;
+  virtual void declare_access (Access& access);
 
-  Component::Handle_set components (const std::string& s);
+  Component::Handle_set components (const Symbol& s);
+  std::size_t revision (const Symbol& s);
   template <typename T>
-  std::shared_ptr<T> get (const std::string& entity, const std::string& component)
+  std::shared_ptr<T> get (const Symbol& entity, const Symbol& component)
   { return m_content.get<T>(entity, component); }
   template <typename T>
   std::shared_ptr<T> get (const Fast_access_component& fac) { return m_content.get<T>(fac); }
   template <typename T>
-  std::shared_ptr<T> request (const std::string& entity, const std::string& component)
+  std::shared_ptr<T> request (const Symbol& entity, const Symbol& component)
   { return m_content.request<T>(entity, component); }
   template <typename T>
   typename T::const_reference value (const Fast_access_component& fac) { return m_content.value<T>(fac); }
   template <typename T>
-  typename T::const_reference value (const std::string& entity, const std::string& component)
+  typename T::const_reference value (const Symbol& entity, const Symbol& component)
   { return m_content.value<T>(entity, component); }
   template <typename T>
-  typename T::value_type value (const std::string& entity, const std::string& component,
+  typename T::value_type value (const Symbol& entity, const Symbol& component,
                                 const typename T::value_type& default_value)
   { return m_content.value<T>(entity, component, default_value); }
   template <typename T, typename ... Args>
@@ -77,19 +114,19 @@ public:
   template <typename T>
   void set (const std::shared_ptr<T>& t) { return m_content.set<T>(t); }
   template <typename T, typename ... Args>
-  std::shared_ptr<T> get_or_set (const std::string& entity, const std::string& component, Args&& ... args)
+  std::shared_ptr<T> get_or_set (const Symbol& entity, const Symbol& component, Args&& ... args)
   { return m_content.get_or_set<T>(entity, component, std::forward<Args>(args)...); }
   template <typename T, typename ... Args>
   std::shared_ptr<T> set_fac (const Fast_access_component& fac, Args&& ... args)
   { return m_content.set_fac<T>(fac, std::forward<Args>(args)...); }
-  bool remove (const std::string& entity, const std::string& component, bool optional = false);
+  bool remove (const Symbol& entity, const Symbol& component, bool optional = false);
   bool remove (Component::Handle handle, bool optional = false);
-  void emit (const std::string& entity, const std::string& component);
-  bool receive (const std::string& entity, const std::string& component);
-  bool signal (const std::string& entity, const std::string& component);
+  void emit (const Symbol& entity, const Symbol& component);
+  bool receive (const Symbol& entity, const Symbol& component);
+  bool signal (const Symbol& entity, const Symbol& component);
   Component::Status_handle status();
   const std::string& locale (const std::string& line);
-  const std::string& locale_get (const std::string& entity, const std::string& component);
+  const std::string& locale_get (const Symbol& entity, const Symbol& component);
 };
 
 using Handle = std::shared_ptr<Base>;
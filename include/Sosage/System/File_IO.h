@@ -35,9 +35,24 @@
 #include <Sosage/Core/File_IO.h>
 #include <Sosage/System/Base.h>
 
+#include <atomic>
+#include <future>
 #include <unordered_set>
 
-namespace Sosage::System
+namespace Sosage
+{
+
+namespace Config
+{
+// Folders where a YAML value may refer to an asset to prefetch
+constexpr auto prefetch_folders = { "images/animations", "images/backgrounds",
+                                    "images/characters", "images/objects",
+                                    "images/scenery", "images/windows",
+                                    "sounds/effects" };
+constexpr auto prefetch_extensions = { ".png", ".graph", ".ogg" };
+} // namespace Config
+
+namespace System
 {
 
 class File_IO : public Base
@@ -47,9 +62,18 @@ private:
   using Function = std::function<void(const std::string&, const Core::File_IO::Node&)>;
   std::unordered_map<std::string, Function> m_dispatcher;
 
+  // Prefetch of rooms reachable from the current one
+  std::vector<std::string> m_adjacent_rooms;
+  std::unordered_map<std::string, std::shared_future<bool> > m_prefetched_rooms;
+  std::shared_ptr<std::atomic<bool> > m_prefetch_cancelled;
+  bool m_prefetch_needed;
+  std::size_t m_nb_room_changes;
+  std::size_t m_nb_prefetch_hits;
+
 public:
 
   File_IO (Content& content);
+  virtual ~File_IO();
 
   virtual void run();
 
@@ -74,6 +98,7 @@ private:
   void read_init_functions (const Core::File_IO& input);
   void read_init_global_items (const Core::File_IO& input);
   void read_init_text_defaults (const Core::File_IO& input);
+  void read_init_preloaded_sounds (const Core::File_IO& input);
 
   void read_savefiles (const Core::File_IO& input);
 
@@ -108,8 +133,15 @@ private:
   void read_text (const std::string& id, const Core::File_IO::Node& input);
   void read_window (const std::string& id, const Core::File_IO::Node& input);
 
+  // Implemented in File_IO__prefetch.cpp:
+  void find_adjacent_rooms();
+  void prefetch_adjacent_rooms();
+  void stop_prefetching (const std::string& new_room);
+
 };
 
-} // namespace Sosage::System
+} // namespace System
+
+} // namespace Sosage
 
 #endif // SOSAGE_SYSTEM_FILE_IO_H
@@ -28,6 +28,7 @@
 #define SOSAGE_SYSTEM_GRAPHIC_H
 
 #include <Sosage/Component/Image.h>
+#include <Sosage/Component/Position.h>
 #include <Sosage/Core/Graphic.h>
 #include <Sosage/Content.h>
 #include <Sosage/System/Base.h>
@@ -42,10 +43,24 @@ class Graphic : public Base
 {
 private:
 
+  // Images are kept sorted between frames: the list is only rebuilt
+  // when images or positions are set or removed, and only sorted
+  // again when the depth of an image changes
+  struct Draw_item
+  {
+    Component::Image_handle image;
+    Component::Position_handle position;
+    int z;
+    std::size_t rank; // Order of images at the same depth
+  };
+
   Core::Graphic m_core;
   Clock m_clock;
   double m_start;
   double m_loop;
+  std::vector<Draw_item> m_draw_list;
+  std::size_t m_image_revision;
+  std::size_t m_position_revision;
 
 public:
 
@@ -55,8 +70,16 @@ public:
 
   virtual void run();
 
+  virtual void declare_access (Access& access);
+
   void run_loading();
 
+private:
+
+  void update_draw_list();
+
+public:
+
   void display_error (const std::string& error) { m_core.display_error(error); }
 
 };
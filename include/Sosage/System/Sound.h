@@ -44,6 +44,8 @@ public:
   Sound (Content& content);
 
   virtual void run();
+
+  virtual void declare_access (Access& access);
 };
 
 } // namespace Sosage::System
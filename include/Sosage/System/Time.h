@@ -37,6 +37,10 @@ namespace Sosage
 namespace Config
 {
 constexpr double speedup_factor = 2.;
+constexpr int default_refresh_rate = 60;
+constexpr std::size_t vsync_probe_frames = 30;
+constexpr double vsync_tolerance = 0.85;
+constexpr double vsync_present_ratio = 0.25; // of refresh period
 }
 
 namespace System
@@ -47,6 +51,21 @@ class Time : public Base
   Clock m_clock;
   bool m_loading;
 
+  // Frame pacing: frames are only slowed down to the refresh rate of
+  // the display when VSync is not effective. This is probed by letting
+  // a few frames run unpaced when the game starts or the display
+  // changes, and then monitored by checking whether presenting blocks
+  bool m_pacing_started;
+  int m_refresh_rate;
+  int m_display;
+  bool m_vsync_effective;
+  double m_latest_frame;
+  double m_next_check;
+  std::size_t m_probe_frames;
+  double m_probe_time;
+  std::size_t m_present_frames;
+  double m_present_time;
+
 public:
 
   Time (Content& content);
@@ -57,6 +76,7 @@ public:
 private:
 
   void limit_fps();
+  void start_vsync_probe();
 };
 
 } // namespace System
@@ -32,8 +32,25 @@
 namespace Sosage
 {
 
-Buffer lz4_compress_buffer (void* data, std::size_t size);
-void lz4_decompress_buffer (void* data, std::size_t size, void* out, std::size_t output_size);
+namespace Config
+{
+// Assets are stored uncompressed if compression saves less than this
+constexpr double min_compression_gain = 0.1;
+} // namespace Config
+
+// Codec of each packaged asset, LZ4 and LZ4HC share the same decoder
+enum Codec : unsigned char
+{
+  CODEC_STORED = 0,
+  CODEC_LZ4 = 1,
+  CODEC_LZ4HC = 2
+};
+
+Buffer lz4_compress_buffer (const void* data, std::size_t size);
+void lz4_decompress_buffer (const void* data, std::size_t size, void* out, std::size_t output_size);
+
+Buffer compress_buffer (const void* data, std::size_t size, Codec& codec);
+void decompress_buffer (Codec codec, const void* data, std::size_t size, void* out, std::size_t output_size);
 
 }
 
@@ -27,6 +27,7 @@
 #ifndef SOSAGE_THIRD_PARTY_SDL_H
 #define SOSAGE_THIRD_PARTY_SDL_H
 
+#include <Sosage/Config/platform.h>
 #include <Sosage/Utils/binary_io.h>
 #include <Sosage/Utils/Bitmap_2.h>
 #include <Sosage/Utils/color.h>
@@ -36,6 +37,8 @@
 #include <SDL_ttf.h>
 
 #include <array>
+#include <future>
+#include <map>
 
 namespace Sosage
 {
@@ -43,6 +46,14 @@ namespace Sosage
 namespace Config
 {
 constexpr int text_outline = 10;
+constexpr std::size_t texture_upload_batch = 8;
+constexpr std::size_t texture_memory_budget = (android ? 192 : 512) * 1024 * 1024;
+constexpr int atlas_page_size = 2048;
+constexpr int atlas_max_image_size = 512;
+constexpr int atlas_padding = 1;
+constexpr auto atlas_folders = { "images/objects", "images/inventory", "images/interface" };
+constexpr int glyph_page_size = 1024;
+constexpr int text_wrap_width = 1920;
 } // namespace Config
 
 namespace Third_party
@@ -66,6 +77,17 @@ public:
 
   using Font_base = std::tuple<TTF_Font*, TTF_Font*, Buffer*>;
 
+  // Text is drawn as quads sampled from the glyph atlas, positions
+  // are relative to the top-left corner of the text
+  struct Glyph_quad
+  {
+    std::size_t page;
+    SDL_Rect source;
+    int x;
+    int y;
+    SDL_Color color;
+  };
+
   struct Image_base
   {
     std::vector<SDL_Texture*> texture;
@@ -74,6 +96,32 @@ public:
     int width;
     int height;
 
+    // Highlights are generated from the texture the first time they
+    // are displayed (unless explicitly given)
+    bool with_highlight = false;
+
+    // Small images are packed in a shared atlas page: texture[0] is
+    // then the page texture, and the image lies at the given offset
+    int atlas = -1;
+    SDL_Point offset = { 0, 0 };
+    bool pinned = false; // Created while pinning, packed on pinned pages
+
+    // Texts have no texture of their own, only glyphs (none at all
+    // for empty texts)
+    std::vector<Glyph_quad> glyphs;
+    bool text = false;
+
+    // Three-slice images (labels) have no texture of their own either:
+    // caps are shared images and the middle is a solid rectangle,
+    // all drawn at their place in the image area
+    bool sliced = false;
+    std::shared_ptr<Image_base> left;
+    std::shared_ptr<Image_base> right;
+    SDL_Rect left_area = { 0, 0, 0, 0 };
+    SDL_Rect middle_area = { 0, 0, 0, 0 };
+    SDL_Rect right_area = { 0, 0, 0, 0 };
+    SDL_Color middle_color = { 0, 0, 0, 255 };
+
     Image_base () { }
     Image_base (const Image_base&) = delete;
   };
@@ -86,6 +134,8 @@ public:
                                  SDL_Texture* highlight,
                                  int width, int height);
 
+  static std::size_t texture_memory (const Image_base& image);
+
   using Image_manager = Resource_manager<Image_base>;
   using Font_manager = Resource_manager<Font_base>;
 
@@ -93,6 +143,43 @@ public:
   using Image = typename Image_manager::Resource_handle;
   using Font = typename Font_manager::Resource_handle;
 
+  // Tiles decompressed by a worker, waiting to be uploaded as textures
+  struct Decoded_image
+  {
+    std::vector<SDL_Surface*> tiles;
+    Bitmap_2 mask;
+    bool atlas = false;
+  };
+
+  // Pinned images have their own pages so that pages of room images
+  // can empty. Slots of released images are reused, and a page is
+  // destroyed (its entry reused) once all its images are released.
+  struct Atlas_page
+  {
+    SDL_Texture* texture = nullptr;
+    int shelf_y = 0;
+    int shelf_height = 0;
+    int cursor_x = 0;
+    int size = 0;
+    std::size_t nb_images = 0;
+    bool pinned = false;
+    std::vector<SDL_Rect> free_slots;
+  };
+
+  // Glyphs are rasterized once in white and tinted when drawn, offset
+  // is the shift of the rasterized glyph relative to the pen position
+  struct Glyph
+  {
+    std::size_t page = 0;
+    SDL_Rect source = { 0, 0, 0, 0 };
+    int offset = 0;
+    int advance = 0;
+  };
+
+  using Glyph_key = std::pair<TTF_Font*, Uint32>;
+
+  using Pending_image = std::pair<Image, std::future<Decoded_image> >;
+
   struct Surface_access
   {
     SDL_Surface* surface;
@@ -114,13 +201,26 @@ public:
   static void* m_hbuffer;
   static int m_max_texture_width;
   static int m_max_texture_height;
+  static bool m_deferred_loading;
+  static bool m_pin_new_images;
+  static SDL_BlendMode m_highlight_blend_mode;
+  static std::vector<Pending_image> m_pending_images;
+  static std::vector<Atlas_page> m_atlas_pages;
+  static std::vector<Atlas_page> m_glyph_pages;
+  static std::map<Glyph_key, Glyph> m_glyphs;
+  static std::vector<SDL_Vertex> m_glyph_vertices;
+  static std::vector<int> m_glyph_indices;
+  static double m_present_time;
   Surface m_icon;
 
 public:
 
   static std::pair<Image, double> create_rectangle (int w, int h, int r, int g, int b, int a);
   static Image load_image (const std::string& file_name, bool with_mask, bool with_highlight);
-  static Image compose (const std::initializer_list<Image>& images);
+  static void start_deferred_loading();
+  static void finish_deferred_loading (const std::function<void()>& callback);
+  static Image create_slices (const Image& left, int width, int height,
+                              int r, int g, int b, const Image& right);
   static Font load_font (const std::string& file_name, int size);
   static Bitmap_2 create_mask (SDL_Surface* surf);
   static void fix_transparent_borders (SDL_Surface* image);
@@ -136,14 +236,38 @@ public:
 
   // Specifically for ground map
   static Surface load_surface (const std::string& file_name);
-  static std::array<unsigned char, 3> get_color (Surface image, int x, int y);
+  static std::vector<unsigned char> get_colors (Surface image);
 
   static void display_error(const std::string& error);
 
+private:
+
+  static Decoded_image decode_image (const std::string& file_name, int width, int height,
+                                     int format, bool with_mask);
+  static bool fits_in_atlas (const std::string& file_name, int width, int height);
+  static void create_tile_texture (Image_base* image, std::size_t idx,
+                                   SDL_Surface* tile, bool atlas);
+  static bool pack_in_atlas (Image_base* image, SDL_Surface* tile);
+  static bool allocate_in_atlas (std::vector<Atlas_page>& pages, int page_size,
+                                 bool pinned, int slot_width, int slot_height,
+                                 std::size_t& page_idx, int& x, int& y);
+  static SDL_Texture* highlight (Image_base* image, std::size_t idx, int width, int height);
+  static void upload_to_atlas (const Atlas_page& page, SDL_Surface* surface, int x, int y);
+  static void release_from_atlas (Image_base* image);
+  static const Glyph& glyph (TTF_Font* font, Uint32 codepoint);
+  static void forget_glyphs (TTF_Font* font);
+  static Image layout_text (const Font& font, const SDL_Color& color,
+                            const std::string& text, bool outlined);
+  static void draw_glyphs (const Image_base* image, unsigned char alpha,
+                           const SDL_Rect& source, const SDL_FRect& target);
+
+public:
+
   SDL ();
   ~SDL ();
 
   void clear_managers();
+  static void pin_new_resources (bool pin);
 
   void init (int& window_width, int& window_height, bool fullscreen);
 
@@ -151,7 +275,14 @@ public:
   void update_view();
   void toggle_fullscreen(bool fullscreen);
   void toggle_cursor(bool visible);
+  static int refresh_rate();
+  static int display();
+  // Time spent in the latest present (in seconds)
+  static double present_time();
   void begin();
+  void draw_slices (const Image_base* image, unsigned char alpha,
+                    unsigned char highlight_alpha,
+                    const SDL_Rect& source, const SDL_FRect& target);
   void draw (const Image& image, unsigned char alpha,
              unsigned char highlight_alpha,
              const int xsource, const int ysource,
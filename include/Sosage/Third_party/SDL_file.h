@@ -41,6 +41,15 @@ struct Asset
   operator bool() const;
 };
 
+// Read-only view of a whole file, paged in lazily by the OS
+struct Mapping
+{
+  const char* data = nullptr;
+  std::size_t size = 0;
+  void* handle = nullptr;
+  operator bool() const;
+};
+
 Asset open (const std::string& filename, bool write = false);
 Asset open (const void* memory, std::size_t size);
 std::size_t read (Asset asset, void* ptr, std::size_t max_num);
@@ -48,6 +57,8 @@ void write (Asset asset, const char* str);
 std::size_t tell (Asset asset);
 void seek (Asset asset, std::size_t pos);
 void close (Asset asset);
+Mapping map (const std::string& filename);
+void unmap (Mapping& mapping);
 std::string base_path();
 std::string pref_path();
 
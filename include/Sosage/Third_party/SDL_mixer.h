@@ -28,12 +28,14 @@
 #define SOSAGE_THIRD_PARTY_SDL_MIXER_H
 
 #include <Sosage/Config/platform.h>
+#include <Sosage/Utils/Resource_manager.h>
 
 #ifdef SOSAGE_LINKED_WITH_SDL_MIXER
 
 #include <SDL_mixer.h>
 
 #include <array>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -45,6 +47,7 @@ namespace Config
 constexpr int max_music_volume = 128;
 constexpr int max_panning = 255;
 constexpr int sound_channels = 16;
+constexpr std::size_t sound_memory_budget = (android ? 16 : 64) * 1024 * 1024;
 } // namespace Config
 
 namespace Third_party
@@ -54,14 +57,40 @@ class SDL_mixer
 {
 public:
 
+#ifdef SOSAGE_LINKED_WITH_VORBISFILE
+  struct Music_stream;
+  using Music = Music_stream*;
+#else
   using Music = Mix_Chunk*;
-  using Sound = Mix_Chunk*;
+#endif
+  using Sound_manager = Resource_manager<Mix_Chunk>;
+  using Sound = typename Sound_manager::Resource_handle;
 
 private:
 
   static std::array<bool, Config::sound_channels> m_available_channels;
+
+  // Decoded sounds are shared by all components using the same file
+  // and kept across rooms as long as they fit in budget
+  static Sound_manager m_sounds;
   std::vector<int> m_music_channels;
 
+#ifdef SOSAGE_LINKED_WITH_VORBISFILE
+  // Musics are decoded incrementally from their packaged OGG and all
+  // tracks are mixed together in the music hook, which keeps them
+  // sample-aligned (SDL Mixer only streams one music at a time)
+  static std::vector<Music_stream*> m_streams;
+  static std::mutex m_streams_mutex;
+  static std::size_t m_mixed_frames;
+  static int m_frequency;
+  static int m_channels;
+
+  static void mix_streams (void*, Uint8* stream, int len);
+  static void request_start (Music_stream* music, double position);
+  static void seek (Music_stream* music, double position);
+  static void read_stream (Music_stream* music, Sint16* out, std::size_t nb_frames);
+#endif
+
 public:
 
   SDL_mixer ();
@@ -73,6 +102,9 @@ public:
   static void delete_music (Music& music);
   static void delete_sound (Sound& sound);
 
+  static void clear_managers();
+  static void pin_new_resources (bool pin);
+
   void set_music_channels (std::size_t nb);
   void start_music (const Music& music, int channel, double volume);
   void stop_music(const Music& music, int channel);
@@ -87,6 +119,7 @@ public:
 private:
 
   int reserve_channel();
+  static Mix_Chunk* decode_sound (const std::string& file_name);
 };
 
 } // namespace Third_party
@@ -28,6 +28,7 @@
 #define SOSAGE_THIRD_PARTY_SDL_MIXER_EXT_H
 
 #include <Sosage/Config/platform.h>
+#include <Sosage/Utils/Resource_manager.h>
 
 #ifdef SOSAGE_LINKED_WITH_SDL_MIXER_EXT
 
@@ -48,6 +49,7 @@ constexpr int max_music_volume = 64;
 constexpr int max_sound_volume = 128;
 constexpr int max_panning = 255;
 constexpr int sound_channels = 16;
+constexpr std::size_t sound_memory_budget = (android ? 16 : 64) * 1024 * 1024;
 } // namespace Config
 
 namespace Third_party
@@ -58,12 +60,17 @@ class SDL_mixer_ext
 public:
 
   using Music = std::pair<Mix_Music*, Asset>;
-  using Sound = Mix_Chunk*;
+  using Sound_manager = Resource_manager<Mix_Chunk>;
+  using Sound = typename Sound_manager::Resource_handle;
 
 private:
 
   static std::array<bool, Config::sound_channels> m_available_channels;
 
+  // Decoded sounds are shared by all components using the same file
+  // and kept across rooms as long as they fit in budget
+  static Sound_manager m_sounds;
+
 public:
 
   SDL_mixer_ext ();
@@ -75,6 +82,9 @@ public:
   static void delete_music (Music& music);
   static void delete_sound (Sound& sound);
 
+  static void clear_managers();
+  static void pin_new_resources (bool pin);
+
   void set_music_channels (std::size_t nb);
   void start_music (const Music& music, int channel, double volume);
   void stop_music(const Music& music, int channel);
@@ -89,6 +99,7 @@ public:
 private:
 
   int reserve_channel();
+  static Mix_Chunk* decode_sound (const std::string& file_name);
 };
 
 } // namespace Third_party
@@ -41,6 +41,9 @@ public:
 
   static Unit now();
   static void wait (const Duration& d);
+
+  // High resolution time in seconds
+  static double precise_now();
 };
 
 } // namespace Sosage::Third_party
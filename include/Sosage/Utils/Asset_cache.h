@@ -0,0 +1,78 @@
+/*
+  [include/Sosage/Utils/Asset_cache.h]
+  Bounded cache of decompressed assets.
+
+  =====================================================================
+
+  This file is part of SOSAGE.
+
+  SOSAGE is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SOSAGE is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with SOSAGE.  If not, see <https://www.gnu.org/licenses/>.
+
+  =====================================================================
+
+  Author(s): Simon Giraudot <sosage@ptilouk.net>
+*/
+
+#ifndef SOSAGE_UTILS_ASSET_CACHE_H
+#define SOSAGE_UTILS_ASSET_CACHE_H
+
+#include <Sosage/Config/platform.h>
+#include <Sosage/Utils/binary_io.h>
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Sosage
+{
+
+namespace Config
+{
+constexpr std::size_t asset_cache_budget = (android ? 32 : 128) * 1024 * 1024;
+} // namespace Config
+
+// Thread-safe, least recently used entries are evicted first
+class Asset_cache
+{
+  using LRU_list = std::list<std::string>;
+
+  struct Entry
+  {
+    Buffer data;
+    LRU_list::iterator lru;
+  };
+
+  static std::mutex m_mutex;
+  static std::unordered_map<std::string, Entry> m_entries;
+  static LRU_list m_lru;
+  static std::size_t m_size;
+  static std::size_t m_hits;
+  static std::size_t m_misses;
+
+public:
+
+  static bool contains (const std::string& key);
+  static bool fetch (const std::string& key, void* memory, std::size_t size);
+  static void insert (const std::string& key, Buffer&& data);
+  static void clear();
+
+  static std::size_t size();
+  static std::size_t hits();
+  static std::size_t misses();
+};
+
+} // namespace Sosage
+
+#endif // SOSAGE_UTILS_ASSET_CACHE_H
@@ -27,9 +27,11 @@
 #ifndef SOSAGE_UTILS_ASSET_MANAGER_H
 #define SOSAGE_UTILS_ASSET_MANAGER_H
 
+#include <Sosage/Third_party/LZ4.h>
 #include <Sosage/Third_party/SDL_file.h>
 #include <Sosage/Utils/binary_io.h>
 
+#include <string_view>
 #include <unordered_map>
 
 namespace Sosage
@@ -37,6 +39,12 @@ namespace Sosage
 
 namespace IO = Third_party::SDL_file;
 
+namespace Config
+{
+// Packages end with an index of all their assets followed by this tag
+constexpr std::string_view package_index_magic = "SCI2";
+} // namespace Config
+
 constexpr auto packages = { "general", "locale", "images",
                             "images_animations",
                             "images_scenery", "sounds" };
@@ -81,6 +89,7 @@ struct Packaged_asset
   std::size_t position = 0;
   std::size_t compressed_size = 0;
   std::size_t size = 0;
+  Codec codec = CODEC_STORED;
 
   // Only used by images
   unsigned short width = 0;
@@ -92,26 +101,48 @@ struct Packaged_asset
 
 using Package_asset_map = std::unordered_map<std::string, Packaged_asset>;
 
+// Package content is either memory-mapped (read-only, paged in
+// lazily) or fully loaded in RAM if mapping is not available
+struct Package_buffer
+{
+  IO::Mapping mapping;
+  Buffer buffer;
+
+  const char* data() const
+  {
+    return (mapping ? mapping.data : buffer.data());
+  }
+};
+
 class Asset_manager
 {
   static std::string folder_name;
-  static std::vector<Buffer> buffers;
+  static std::vector<Package_buffer> buffers;
   static Package_asset_map package_asset_map;
 
 public:
 
   static bool packaged();
   static bool init (const std::string& folder, bool scap_mode = false);
+  static void shutdown();
   static Asset open_pref (const std::string& filename, bool write = false);
   static Asset open (const std::string& filename, bool file_is_package = false);
   static bool exists (const std::string& filename);
   static std::tuple<int, int, int> image_info (const std::string& filename);
-  static void open (const std::string& filename, void* memory, Uint32 x = 0, Uint32 y = 0, bool highlight = false);
+  static void open (const std::string& filename, void* memory, Uint32 x = 0, Uint32 y = 0);
+  static void prefetch (const std::string& filename);
 
   static const Package_asset_map& asset_map();
 
+#ifdef SOSAGE_SCAP
+  static void append_index (const std::string& package_file);
+#endif
+
 private:
 
+  static std::size_t read_records (Asset& asset, std::size_t buffer_id, Package_asset_map& map);
+  static bool read_index (Asset& asset, std::size_t buffer_id, Package_asset_map& map,
+                          std::size_t& end);
   static std::string local_file_name (const std::string& filename);
 };
 
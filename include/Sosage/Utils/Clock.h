@@ -32,6 +32,11 @@
 namespace Sosage
 {
 
+namespace Config
+{
+constexpr double sleep_spin_margin = 0.002; // seconds
+} // namespace Config
+
 using namespace Core;
 
 class Clock
@@ -52,6 +57,7 @@ public:
   void set (double time);
   void update(bool verbose = false);
   void sleep (double time);
+  void precise_sleep (double time);
   double fps() const;
   double time() const;
 
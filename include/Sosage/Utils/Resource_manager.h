@@ -31,7 +31,9 @@
 #include <Sosage/Content.h>
 #include <Sosage/Utils/Clock.h>
 
+#include <algorithm>
 #include <functional>
+#include <vector>
 
 namespace Sosage
 {
@@ -42,41 +44,87 @@ class Resource_manager
 public:
 
   using Resource_handle = std::shared_ptr<Resource>;
-  using Data = std::unordered_map<std::string, Resource_handle>;
-  using iterator = typename Data::iterator;
 
 private:
 
+  struct Entry
+  {
+    Resource_handle handle;
+    std::size_t size = 0;
+    std::size_t last_use = 0;
+    bool pinned = false;
+  };
+
+  using Data = std::unordered_map<std::string, Entry>;
+  using iterator = typename Data::iterator;
+
   Data m_data;
   std::function<void(Resource*)> m_deleter;
+  std::function<std::size_t(const Resource&)> m_size_of;
+  std::size_t m_budget;
+  std::size_t m_memory;
+  std::size_t m_clock;
+  bool m_pin_new_resources;
 
 public:
 
+  // Unused resources are kept as long as the total size (given by
+  // size_of) stays under budget
   Resource_manager(const std::function<void(Resource*)>& deleter
-                   = [](Resource* r) { delete r; })
-    : m_deleter(deleter)
+                   = [](Resource* r) { delete r; },
+                   const std::function<std::size_t(const Resource&)>& size_of
+                   = [](const Resource&) { return std::size_t(0); },
+                   std::size_t budget = 0)
+    : m_deleter(deleter), m_size_of(size_of), m_budget(budget)
+    , m_memory(0), m_clock(0), m_pin_new_resources(false)
   { }
 
+  // Removes all unused resources, pinned or not
   void clear()
   {
     Data new_data;
     for (const auto& d : m_data)
-      if (d.second.use_count() > 1)
+      if (d.second.handle.use_count() > 1)
         new_data.insert (d);
-      else
-      {
-//        debug << "Remove " << typeid(Resource*).name() << " " << d.first << std::endl;
-      }
     m_data.swap(new_data);
+    update_memory();
+  }
+
+  // Removes least recently used resources until budget is met
+  void shrink()
+  {
+    update_memory();
+
+    std::vector<iterator> candidates;
+    for (iterator it = m_data.begin(); it != m_data.end(); ++ it)
+      if (!it->second.pinned && it->second.handle.use_count() == 1)
+        candidates.push_back (it);
+
+    std::sort (candidates.begin(), candidates.end(),
+               [](const iterator& a, const iterator& b) -> bool
+               { return a->second.last_use < b->second.last_use; });
+
+    for (iterator it : candidates)
+    {
+      if (m_memory <= m_budget)
+        break;
+      m_memory -= it->second.size;
+      m_data.erase (it);
+    }
   }
 
+  // Resources created while pinning is on are never removed by shrink()
+  void pin_new_resources (bool pin) { m_pin_new_resources = pin; }
+
   std::size_t size() const { return m_data.size(); }
+  std::size_t memory() const { return m_memory; }
 
   Resource_handle get (const std::string& key)
   {
     iterator out = m_data.find(key);
     check (out != m_data.end(), "Can't find resource " + key);
-    return out->second;
+    out->second.last_use = ++ m_clock;
+    return out->second.handle;
   }
 
   Resource_handle make_single_base (const std::function<Resource*()>& f)
@@ -96,11 +144,28 @@ public:
   {
     typename Data::iterator iter;
     bool inserted;
-    std::tie (iter, inserted) = m_data.insert (std::make_pair (key, Resource_handle()));
+    std::tie (iter, inserted) = m_data.insert (std::make_pair (key, Entry()));
     if (inserted)
-      iter->second = make_single(std::forward<F>(f), std::forward<Args>(args)...);
+    {
+      iter->second.handle = make_single(std::forward<F>(f), std::forward<Args>(args)...);
+      iter->second.pinned = m_pin_new_resources;
+    }
+    iter->second.last_use = ++ m_clock;
+
+    return iter->second.handle;
+  }
 
-    return iter->second;
+private:
+
+  // Sizes are computed lazily as some resources are filled after creation
+  void update_memory()
+  {
+    m_memory = 0;
+    for (auto& d : m_data)
+    {
+      d.second.size = m_size_of (*d.second.handle);
+      m_memory += d.second.size;
+    }
   }
 };
 
@@ -0,0 +1,81 @@
+/*
+  [include/Sosage/Utils/Symbol.h]
+  Interned strings used as entity and component names.
+
+  =====================================================================
+
+  This file is part of SOSAGE.
+
+  SOSAGE is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SOSAGE is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with SOSAGE.  If not, see <https://www.gnu.org/licenses/>.
+
+  =====================================================================
+
+  Author(s): Simon Giraudot <sosage@ptilouk.net>
+*/
+
+#ifndef SOSAGE_UTILS_SYMBOL_H
+#define SOSAGE_UTILS_SYMBOL_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace Sosage
+{
+
+// A symbol points to a unique copy of a string: comparing and hashing
+// symbols only compares and hashes pointers. Interned strings are
+// never released (the set of names used by a game is small).
+class Symbol
+{
+  const std::string* m_str;
+
+public:
+
+  Symbol ();
+  Symbol (const std::string& str);
+  Symbol (const char* str);
+
+  const std::string& str() const { return *m_str; }
+  operator const std::string& () const { return *m_str; }
+  std::size_t hash() const { return std::hash<const std::string*>()(m_str); }
+
+  // Concatenations are cached too, so that building names like
+  // id + "_body" every frame doesn't allocate
+  Symbol operator+ (const char* suffix) const;
+
+  friend bool operator== (const Symbol& a, const Symbol& b) { return a.m_str == b.m_str; }
+  friend bool operator!= (const Symbol& a, const Symbol& b) { return a.m_str != b.m_str; }
+  // Strings are compared so that ordering doesn't depend on interning order
+  friend bool operator< (const Symbol& a, const Symbol& b) { return *a.m_str < *b.m_str; }
+
+private:
+
+  static const std::string* intern (std::string_view str);
+};
+
+inline std::ostream& operator<< (std::ostream& os, const Symbol& s)
+{
+  return os << s.str();
+}
+
+struct Symbol_hash
+{
+  std::size_t operator() (const Symbol& s) const { return s.hash(); }
+};
+
+} // namespace Sosage
+
+#endif // SOSAGE_UTILS_SYMBOL_H
@@ -0,0 +1,105 @@
+/*
+  [include/Sosage/Utils/Worker_pool.h]
+  Background threads for loading tasks.
+
+  =====================================================================
+
+  This file is part of SOSAGE.
+
+  SOSAGE is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SOSAGE is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with SOSAGE.  If not, see <https://www.gnu.org/licenses/>.
+
+  =====================================================================
+
+  Author(s): Simon Giraudot <sosage@ptilouk.net>
+*/
+
+#ifndef SOSAGE_UTILS_WORKER_POOL_H
+#define SOSAGE_UTILS_WORKER_POOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Sosage
+{
+
+namespace Config
+{
+constexpr std::size_t max_worker_threads = 4;
+} // namespace Config
+
+class Worker_pool
+{
+  std::vector<std::thread> m_threads;
+  std::deque<std::function<void()> > m_jobs;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  bool m_stop;
+
+  Worker_pool (const Worker_pool&) = delete;
+
+public:
+
+  // If no thread is used, jobs are run right away by the caller
+  Worker_pool (std::size_t nb_threads);
+  ~Worker_pool();
+
+  std::size_t size() const;
+
+  template <typename F>
+  std::future<std::invoke_result_t<F> > submit (F&& f)
+  {
+    using Result = std::invoke_result_t<F>;
+    auto task = std::make_shared<std::packaged_task<Result()> >(std::forward<F>(f));
+    std::future<Result> out = task->get_future();
+    if (m_threads.empty())
+    {
+      (*task)();
+      return out;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock (m_mutex);
+      m_jobs.emplace_back ([task]() { (*task)(); });
+    }
+    m_condition.notify_one();
+    return out;
+  }
+
+private:
+
+  void work();
+};
+
+Worker_pool& workers();
+
+// Keep calling callback (typically, the loading screen) until result is ready
+template <typename T>
+T wait_for (std::future<T>& future, const std::function<void()>& callback)
+{
+  while (future.wait_for (std::chrono::milliseconds(1)) != std::future_status::ready)
+    callback();
+  return future.get();
+}
+
+} // namespace Sosage
+
+#endif // SOSAGE_UTILS_WORKER_POOL_H
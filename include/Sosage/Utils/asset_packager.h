@@ -37,15 +37,20 @@ namespace Sosage::SCAP
 constexpr unsigned int surface_format = SDL_PIXELFORMAT_ARGB8888;
 constexpr unsigned int flat_surface_format = SDL_PIXELFORMAT_RGB888;
 
+// Salt of cache keys: bump it whenever processing of files (borders,
+// masks, tiles, graphs) or the format of records changes
+constexpr unsigned int cache_version = 1;
+
 std::string package (const std::string& filename);
 
 using Output_file = std::shared_ptr<std::ofstream>;
 using Package_files = std::unordered_map<std::string, Output_file>;
 
 Package_files open_packages (const std::string& root);
-void write_file (std::ofstream& ofile, const std::string& filename);
-void write_image (std::ofstream& ofile, const std::string& filename, bool is_object);
-void compile_package (const std::string& input_folder, const std::string& output_folder);
+// Cache is disabled if folder is empty, entries not used by the build
+// are removed from it so one folder should be used per data folder
+void compile_package (const std::string& input_folder, const std::string& output_folder,
+                      bool deterministic = false, const std::string& cache_folder = "");
 void decompile_package (const std::string& filename, std::string folder);
 
 } // namespace Sosage::SCAP
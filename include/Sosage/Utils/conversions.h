@@ -58,6 +58,9 @@ inline std::string to_string (const T& t, const Ts& ... ts)
 
 void capitalize(std::string& str);
 
+// Invalid bytes are skipped
+std::vector<unsigned int> utf8_codepoints (const std::string& str);
+
 template <typename Set, typename T>
 bool contains (const Set& set, const T& t)
 {
@@ -41,7 +41,7 @@
 namespace Sosage
 {
 
-extern char* dbg_location;
+extern thread_local char* dbg_location;
 
 #if !defined(SOSAGE_DEBUG)
 #define debug if(false) std::cerr
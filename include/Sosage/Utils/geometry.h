@@ -242,6 +242,8 @@ class Segment
 public:
 
   Segment (const Point& source, const Point& target);
+  const Point& source() const;
+  const Point& target() const;
   Vector to_vector() const;
   Line to_line() const;
   Box box() const;
@@ -64,7 +64,7 @@ const Id& Base::id() const
 
 const std::string& Base::entity() const
 {
-  return m_id.first;
+  return m_id.first.str();
 }
 
 // Special handling of entity for characters
@@ -97,12 +97,12 @@ std::string Base::target_entity() const
 const std::string& Base::component() const
 {
   SOSAGE_COUNT(Component__component);
-  return m_id.second;
+  return m_id.second.str();
 }
 
 std::string Base::str() const
 {
-  std::string out = str_name() + "(" + m_id.first + ":" + m_id.second + ")";
+  std::string out = str_name() + "(" + entity() + ":" + component() + ")";
   std::string v = str_value();
   if (v != "")
     out += " = " + v;
@@ -31,11 +31,15 @@
 #include <Sosage/Utils/profiling.h>
 
 #include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <functional>
-#include <queue>
 #include <set>
 
+#ifdef SOSAGE_SCAP
+#include <tbb/parallel_for.h>
+#endif
+
 //#define SOSAGE_DEBUG_GROUND_MAP
 #ifdef SOSAGE_DEBUG_GROUND_MAP
 #  define debug_gm debug
@@ -76,6 +80,76 @@ Ground_map::GVertex Ground_map::add_vertex (std::map<Point, Ground_map::GVertex>
   return it.first->second;
 }
 
+template <typename Functor>
+void Ground_map::for_each_cell (const Point& a, const Point& b, const Functor& functor) const
+{
+  // Cells on the sides of the grid extend to infinity, so that
+  // segments going out of the image are handled consistently
+  const double size = double(Config::ground_grid_cell_size);
+  const double margin = 0.5;
+  const double inf = std::numeric_limits<double>::infinity();
+
+  auto clamp = [](int v, int max) -> int { return std::max(0, std::min(v, max - 1)); };
+
+  double ymin = std::min(a.y(), b.y()) - margin;
+  double ymax = std::max(a.y(), b.y()) + margin;
+  int rmin = clamp (int(std::floor(ymin / size)), m_grid_height);
+  int rmax = clamp (int(std::floor(ymax / size)), m_grid_height);
+
+  double dx = b.x() - a.x();
+  double dy = b.y() - a.y();
+
+  for (int r = rmin; r <= rmax; ++ r)
+  {
+    double ylo = std::max (ymin, (r == 0 ? -inf : r * size));
+    double yhi = std::min (ymax, (r == m_grid_height - 1 ? inf : (r + 1) * size));
+
+    double xmin, xmax;
+    if (std::abs(dy) < 1e-9)
+    {
+      xmin = std::min(a.x(), b.x());
+      xmax = std::max(a.x(), b.x());
+    }
+    else
+    {
+      auto x_at = [&](double y) -> double
+      {
+        double t = std::max(0., std::min(1., (y - a.y()) / dy));
+        return a.x() + t * dx;
+      };
+      xmin = std::min(x_at(ylo), x_at(yhi));
+      xmax = std::max(x_at(ylo), x_at(yhi));
+    }
+
+    int cmin = clamp (int(std::floor((xmin - margin) / size)), m_grid_width);
+    int cmax = clamp (int(std::floor((xmax + margin) / size)), m_grid_width);
+    for (int c = cmin; c <= cmax; ++ c)
+      if (!functor (std::size_t(r * m_grid_width + c)))
+        return;
+  }
+}
+
+void Ground_map::build_grid()
+{
+  m_grid_width = m_width / Config::ground_grid_cell_size + 1;
+  m_grid_height = m_height / Config::ground_grid_cell_size + 1;
+  m_grid.clear();
+  m_grid.resize (std::size_t(m_grid_width * m_grid_height));
+
+  for (GEdge e : m_graph.edges())
+  {
+    if (!m_graph.is_valid(e) || !m_graph[e].border)
+      continue;
+    for_each_cell (m_graph[m_graph.source(e)].point,
+                   m_graph[m_graph.target(e)].point,
+                   [&](std::size_t cell) -> bool
+                   {
+                     m_grid[cell].push_back(e);
+                     return true;
+                   });
+  }
+}
+
 Ground_map::Ground_map (const std::string& entity, const std::string& component,
                         const std::string& file_name,
                         int front_z, int back_z,
@@ -84,11 +158,8 @@ Ground_map::Ground_map (const std::string& entity, const std::string& component,
 {
   SOSAGE_TIMER_START(Ground_map__Ground_map);
   
-  m_image = Core::Graphic::load_surface (file_name);
-
-  int width = m_image->w;
-  int height = m_image->h;
-  m_radius = int(distance(0, 0, width, height));
+  build_raster (file_name);
+  m_radius = int(distance(0, 0, m_width, m_height));
 
   if (Asset_manager::packaged())
   {
@@ -99,16 +170,38 @@ Ground_map::Ground_map (const std::string& entity, const std::string& component,
   }
   else
     build_graph(callback);
-  
-  m_latest_graph = m_graph;
+
+  reset_overlay();
   
   SOSAGE_TIMER_STOP(Ground_map__Ground_map);
 }
 
+void Ground_map::build_raster (const std::string& file_name)
+{
+  Core::Graphic::Surface image = Core::Graphic::load_surface (file_name);
+  m_width = image->w;
+  m_height = image->h;
+
+  std::vector<unsigned char> colors = Core::Graphic::get_colors (image);
+  image.reset();
+
+  m_ground = Bitmap_2 (std::size_t(m_width), std::size_t(m_height), false);
+  m_depth.resize (std::size_t(m_width) * std::size_t(m_height));
+  for (int y = 0; y < m_height; ++ y)
+    for (int x = 0; x < m_width; ++ x)
+    {
+      std::size_t idx = std::size_t(y) * std::size_t(m_width) + std::size_t(x);
+      const unsigned char* c = colors.data() + 3 * idx;
+      bool ground = (c[0] == c[1] && c[0] == c[2]);
+      m_ground.set (std::size_t(x), std::size_t(y), ground);
+      m_depth[idx] = c[0];
+    }
+}
+
 void Ground_map::build_graph (const std::function<void()>& callback)
 {
-  int width = m_image->w;
-  int height = m_image->h;
+  int width = m_width;
+  int height = m_height;
 
   // Build border of ground area
   std::map<Point, GVertex> map_p2v;
@@ -117,25 +210,14 @@ void Ground_map::build_graph (const std::function<void()>& callback)
   {
     for (int y = -1; y < height; ++ y)
     {
-      std::array<unsigned char, 3> c = { 0, 0, 255 };
-      if (x != -1 && y != -1)
-        c = Core::Graphic::get_color (m_image, x, y);
-
-      std::array<unsigned char, 3> c_right = { 0, 0, 255 };
-      if (x != width-1 && y != -1)
-        c_right = Core::Graphic::get_color (m_image, x+1, y);
-
-      std::array<unsigned char, 3> c_down = { 0, 0, 255 };
-      if (y != height-1 && x != -1)
-        c_down = Core::Graphic::get_color (m_image, x, y+1);
-
-      bool g = (c[0] == c[1] && c[0] == c[2]);
-      bool g_right = (c_right[0] == c_right[1] && c_right[0] == c_right[2]);
-      bool g_down = (c_down[0] == c_down[1] && c_down[0] == c_down[2]);
+      // Out of bound pixels are not ground
+      bool g = is_ground (x, y);
+      bool g_right = is_ground (x+1, y);
+      bool g_down = is_ground (x, y+1);
 
       if (g != g_right)
       {
-        unsigned char red = (g ? c[0] : c_right[0]);
+        unsigned char red = (g ? depth(x, y) : depth(x+1, y));
 
         GVertex source = add_vertex (map_p2v, Point (x + 0.5, y - 0.5), red);
         GVertex target = add_vertex (map_p2v, Point (x + 0.5, y + 0.5), red);
@@ -144,7 +226,7 @@ void Ground_map::build_graph (const std::function<void()>& callback)
       }
       if (g != g_down)
       {
-        unsigned char red = (g ? c[0] : c_down[0]);
+        unsigned char red = (g ? depth(x, y) : depth(x, y+1));
 
         GVertex source = add_vertex (map_p2v, Point (x - 0.5, y + 0.5), red);
         GVertex target = add_vertex (map_p2v, Point (x + 0.5, y + 0.5), red);
@@ -207,23 +289,32 @@ void Ground_map::build_graph (const std::function<void()>& callback)
   m_graph.clean();
   m_graph.validity();
 
+  build_grid();
+
   debug << "Edges = " << m_graph.num_edges() << std::endl;
 
-  // Add edges between vertices
-  for (auto it0 = m_graph.vertices().begin(); it0 != m_graph.vertices().end(); ++ it0)
+  // Add edges between vertices. Visibility of a pair only depends on
+  // the border, so all pairs are first checked independently (in
+  // parallel when packaging), then edges are inserted in the same
+  // order as a serial pass to produce the exact same graph.
+  std::size_t nb_vertices = m_graph.num_vertices();
+
+  // For each v0, sequence of [v1, number of vertices along, vertices along...]
+  std::vector<std::vector<GVertex> > visible (nb_vertices);
+
+  auto compute_visible = [&](std::size_t idx)
   {
-    GVertex v0 = *it0;
-    auto it1 = it0;
-    ++ it1;
-    for (; it1 != m_graph.vertices().end(); ++ it1)
+    GVertex v0 (idx);
+    std::vector<GVertex> vertices_along;
+    for (std::size_t idx1 = idx + 1; idx1 < nb_vertices; ++ idx1)
     {
-      GVertex v1 = *it1;
+      GVertex v1 (idx1);
       if (m_graph.is_edge(v0, v1))
         continue;
 
       Segment seg (m_graph[v0].point, m_graph[v1].point);
       if (intersects_border
-          (m_graph, seg,
+          (seg,
            [&](const GEdge& e) -> bool
            {
              return (m_graph.edge_has_vertex(e, v0) ||
@@ -236,7 +327,7 @@ void Ground_map::build_graph (const std::function<void()>& callback)
         continue;
 
       // Snap to close vertices along the way
-      std::vector<GVertex> vertices_along = { v0, v1 };
+      vertices_along = { v0, v1 };
       for (auto v : m_graph.vertices())
       {
         if (v == v0 || v == v1)
@@ -257,17 +348,44 @@ void Ground_map::build_graph (const std::function<void()>& callback)
             < seg.projected_coordinate(m_graph[b].point);
       });
 
-      for (std::size_t i = 0; i < vertices_along.size() - 1; ++ i)
+      visible[idx].push_back (v1);
+      visible[idx].push_back (GVertex(vertices_along.size()));
+      visible[idx].insert (visible[idx].end(), vertices_along.begin(), vertices_along.end());
+    }
+  };
+
+#ifdef SOSAGE_SCAP
+  tbb::parallel_for (std::size_t(0), nb_vertices, compute_visible);
+#else
+  for (std::size_t idx = 0; idx < nb_vertices; ++ idx)
+  {
+    compute_visible (idx);
+    callback();
+  }
+#endif
+
+  for (std::size_t idx = 0; idx < nb_vertices; ++ idx)
+  {
+    GVertex v0 (idx);
+    const std::vector<GVertex>& seq = visible[idx];
+    for (std::size_t i = 0; i < seq.size(); i += 2 + std::size_t(seq[i+1]))
+    {
+      GVertex v1 = seq[i];
+      if (m_graph.is_edge(v0, v1))
+        continue;
+
+      std::size_t nb_along = std::size_t(seq[i+1]);
+      for (std::size_t j = i + 2; j < i + 1 + nb_along; ++ j)
       {
-        GVertex a = vertices_along[i];
-        GVertex b = vertices_along[i+1];
+        GVertex a = seq[j];
+        GVertex b = seq[j+1];
         if (m_graph.is_edge(a, b))
           continue;
         GEdge e = m_graph.add_edge(a, b);
         m_graph[e].border = false;
       }
     }
-    callback();
+    std::vector<GVertex>().swap (visible[idx]);
   }
   debug << "Edges = " << m_graph.num_edges() << std::endl;
 }
@@ -298,6 +416,12 @@ void Ground_map::write (const std::string& filename)
     auto b = (unsigned char)(m_graph[e].border);
     binary_write (ofile, b);
   }
+
+  // Optional all-pairs shortest paths, row by row
+  ofile.write (reinterpret_cast<const char*>(m_distances.data()),
+               std::streamsize(m_distances.size() * sizeof(float)));
+  ofile.write (reinterpret_cast<const char*>(m_next_hops.data()),
+               std::streamsize(m_next_hops.size() * sizeof(unsigned short)));
 }
 
 void Ground_map::read (const std::string& filename)
@@ -321,7 +445,52 @@ void Ground_map::read (const std::string& filename)
     GEdge edge = m_graph.add_edge (s, t);
     m_graph[edge].border = b;
   }
+
+  // Graphs packaged without shortest paths fall back to Dijkstra
+  if (asset.tell() < asset.size())
+  {
+    std::size_t nb = std::size_t(nb_vertices) * std::size_t(nb_vertices);
+    m_distances.resize (nb);
+    m_next_hops.resize (nb);
+    // Tables are large, read each of them at once
+    std::size_t size_distances = nb * sizeof(float);
+    std::size_t size_next_hops = nb * sizeof(unsigned short);
+    check (asset.read (m_distances.data(), size_distances) == size_distances
+           && asset.read (m_next_hops.data(), size_next_hops) == size_next_hops,
+           "Truncated shortest paths in " + filename);
+  }
   asset.close();
+
+  build_grid();
+}
+
+void Ground_map::reset_overlay()
+{
+  m_overlay.linked.resize (m_graph.num_vertices() + 2, 0);
+  for (std::size_t i = 0; i < 2; ++ i)
+  {
+    for (GVertex v : m_overlay.links[i])
+      m_overlay.linked[std::size_t(v)] = 0;
+    m_overlay.links[i].clear();
+    m_overlay.endpoints[i] = Graph::null_vertex();
+    m_overlay.hidden[i] = Graph::null_edge();
+  }
+}
+
+Ground_map::GVertex Ground_map::add_overlay_vertex (std::size_t idx, const Point& point)
+{
+  m_overlay.points[idx] = point;
+  return GVertex(m_graph.num_vertices() + idx);
+}
+
+void Ground_map::add_overlay_edge (std::size_t idx, GVertex v)
+{
+  unsigned char bit = (unsigned char)(1 << idx);
+  if (v == m_overlay.endpoints[idx] || (m_overlay.linked[std::size_t(v)] & bit))
+    return;
+  debug_gm << "New edge " << m_overlay.endpoints[idx] << " -> " << v << std::endl;
+  m_overlay.linked[std::size_t(v)] |= bit;
+  m_overlay.links[idx].push_back (v);
 }
 
 void Ground_map::find_path (Point origin,
@@ -330,13 +499,12 @@ void Ground_map::find_path (Point origin,
 {
   SOSAGE_TIMER_START(Ground_map__find_path);
 
-  m_latest_graph = m_graph;
+  reset_overlay();
 
   GVertex vorigin = Graph::null_vertex();
   GVertex vtarget = Graph::null_vertex();
   GEdge eorigin = Graph::null_edge();
   GEdge etarget = Graph::null_edge();
-  std::set<std::pair<GVertex, GVertex>, Compare_ordered_pair> to_add;
 
   debug_gm << "Finding path from " << origin << " to " << target << std::endl;
   {
@@ -378,45 +546,39 @@ void Ground_map::find_path (Point origin,
   {
     out.push_back (target);
     debug_gm << "Moving along line" << std::endl;
+    SOSAGE_TIMER_STOP(Ground_map__find_path);
     return;
   }
 
-  if (eorigin != Graph::null_edge())
+  // Origin and target are layered on top of the base graph: edges
+  // they split are hidden instead of being deleted
+  if (vorigin == Graph::null_vertex())
+    vorigin = add_overlay_vertex (0, origin);
+  if (vtarget == Graph::null_vertex())
   {
-    vorigin = m_latest_graph.add_vertex({origin});
-    GVertex v0 = m_latest_graph.source(eorigin);
-    GVertex v1 = m_latest_graph.target(eorigin);
-    m_latest_graph.delete_edge(eorigin);
-    to_add.insert (std::make_pair (vorigin, v0));
-    to_add.insert (std::make_pair (vorigin, v1));
+    vtarget = add_overlay_vertex (1, target);
+    debug_gm << "New target vertex " << vtarget << std::endl;
   }
-  else if (vorigin == Graph::null_vertex())
-    vorigin = m_latest_graph.add_vertex({origin});
+  m_overlay.endpoints = { vorigin, vtarget };
+  m_overlay.hidden = { eorigin, etarget };
 
+  if (eorigin != Graph::null_edge())
+    for (GVertex v : { m_graph.source(eorigin), m_graph.target(eorigin) })
+      add_overlay_edge (0, v);
   if (etarget != Graph::null_edge())
-  {
-    vtarget = m_latest_graph.add_vertex({target});
-    GVertex v0 = m_latest_graph.source(etarget);
-    GVertex v1 = m_latest_graph.target(etarget);
-    m_latest_graph.delete_edge(etarget);
-    to_add.insert (std::make_pair (vtarget, v0));
-    to_add.insert (std::make_pair (vtarget, v1));
-  }
-  else if (vtarget == Graph::null_vertex())
-  {
-    vtarget = m_latest_graph.add_vertex({target});
-    debug_gm << "New target vertex " << vtarget << std::endl;
-  }
+    for (GVertex v : { m_graph.source(etarget), m_graph.target(etarget) })
+      add_overlay_edge (1, v);
 
   Segment segment (origin, target);
   
   // If no  border intersected, straight line is fine
   if (!intersects_border
-      (m_latest_graph, segment,
+      (segment,
        [&](const GEdge& e) -> bool
        {
-         return (m_latest_graph.edge_has_vertex(e, vorigin)
-                 || m_latest_graph.edge_has_vertex(e, vtarget));
+         return (is_hidden(e)
+                 || m_graph.edge_has_vertex(e, vorigin)
+                 || m_graph.edge_has_vertex(e, vtarget));
        }))
   {
     debug_gm << "No border intersected, going straight" << std::endl;
@@ -426,59 +588,53 @@ void Ground_map::find_path (Point origin,
     if (is_ground_point(mid))
     {
       out.push_back (target);
-      m_latest_graph = m_graph;
+      reset_overlay();
       SOSAGE_TIMER_STOP(Ground_map__find_path);
       return;
     }
   }
 
   // Insert new edges
-  for (GVertex v : m_latest_graph.vertices())
+  for (GVertex v : m_graph.vertices())
   {
     if (v == vorigin || v == vtarget)
       continue;
 
-    for (GVertex n : { vorigin, vtarget })
+    for (std::size_t i = 0; i < 2; ++ i)
     {
+      GVertex n = m_overlay.endpoints[i];
       debug_gm << "Trying to insert " << v << "-> " << n << std::endl;
-      Point mid = midpoint (m_latest_graph[v].point, m_latest_graph[n].point);
+      Point mid = midpoint (m_graph[v].point, point(n));
       if (!is_ground_point(mid))
       {
         debug_gm << " -> mid point is not ground" << std::endl;
         continue;
       }
         
-      Segment seg (m_latest_graph[v].point, m_latest_graph[n].point);
+      Segment seg (m_graph[v].point, point(n));
       if (intersects_border
-          (m_latest_graph, seg,
+          (seg,
            [&](const GEdge& e) -> bool
            {
-             return ((e == eorigin || e == etarget) || m_latest_graph.edge_has_vertex(e, v));
+             return (is_hidden(e) || m_graph.edge_has_vertex(e, v));
            }))
       {
         debug_gm << " -> segment intersects border" << std::endl;
         continue;
       }
 
-      to_add.insert (std::make_pair(v, n));
+      add_overlay_edge (i, v);
     }
   }
 
-  for (const auto& p : to_add)
-  {
-    debug_gm << "New edge " << p.first << " -> " << p.second << std::endl;
-    GEdge e = m_latest_graph.add_edge(p.first, p.second);
-    m_latest_graph[e].border = false;
-  }
-
-  check (!m_latest_graph.incident_edges(vtarget).empty(), "Can't compute Djikstra from isolated vertex");
+  bool isolated = true;
+  for_each_neighbor (vtarget, [&](GVertex) { isolated = false; });
+  check (!isolated, "Can't compute Djikstra from isolated vertex");
 
-  m_latest_graph.clean();
-  
-  // Dijkstra
-  m_latest_graph.validity();
-
-  shortest_path(vorigin, vtarget, out);
+  if (m_distances.empty())
+    shortest_path(vorigin, vtarget, out);
+  else
+    precomputed_shortest_path(vorigin, vtarget, out);
 
   SOSAGE_TIMER_STOP(Ground_map__find_path);
 }
@@ -487,7 +643,8 @@ void Ground_map::find_path (Point origin, Sosage::Vector direction, std::vector<
 {
   SOSAGE_TIMER_START(Ground_map__find_path_gamepad);
 
-  m_latest_graph = m_graph;
+  // Only walks along the base graph, no temporary vertex needed
+  reset_overlay();
 
   GVertex vertex = Graph::null_vertex();
   GEdge edge = Graph::null_edge();
@@ -530,14 +687,14 @@ void Ground_map::find_path (Point origin, Sosage::Vector direction, std::vector<
     debug_gm << "Iteration " << repeat << ": ";
     if (vertex != Graph::null_vertex())
     {
-      debug_gm << "v" << vertex << " = " << m_latest_graph[vertex].point;
+      debug_gm << "v" << vertex << " = " << m_graph[vertex].point;
     }
     else if (edge != Graph::null_edge())
     {
-      debug_gm << "e" << edge << "(v" << m_latest_graph.source(edge)
-               << ", v" << m_latest_graph.target(edge)
-               << ") = (" << m_latest_graph[m_latest_graph.source(edge)].point
-               << ", " << m_latest_graph[m_latest_graph.target(edge)].point
+      debug_gm << "e" << edge << "(v" << m_graph.source(edge)
+               << ", v" << m_graph.target(edge)
+               << ") = (" << m_graph[m_graph.source(edge)].point
+               << ", " << m_graph[m_graph.target(edge)].point
                << ")" << std::endl;
     }
 
@@ -564,8 +721,8 @@ void Ground_map::find_path (Point origin, Sosage::Vector direction, std::vector<
                              (origin, direction,
                               [&](const GEdge& e) -> bool
                               {
-                                return (m_latest_graph.edge_has_vertex(e, vertex)
-                                        || m_latest_graph.edge_has_vertex(e, vertex));
+                                return (m_graph.edge_has_vertex(e, vertex)
+                                        || m_graph.edge_has_vertex(e, vertex));
                               });
       if (query)
       {
@@ -578,10 +735,10 @@ void Ground_map::find_path (Point origin, Sosage::Vector direction, std::vector<
       {
         GVertex next_vertex = Graph::null_vertex();
         double scalar_max = 0.;
-        for (GEdge e : m_latest_graph.incident_edges(vertex))
+        for (GEdge e : m_graph.incident_edges(vertex))
         {
-          GVertex other = m_latest_graph.other(e, vertex);
-          Sosage::Vector dir (origin, m_latest_graph[other].point);
+          GVertex other = m_graph.other(e, vertex);
+          Sosage::Vector dir (origin, m_graph[other].point);
           dir.normalize();
 
           double scalar = direction * dir;
@@ -595,7 +752,7 @@ void Ground_map::find_path (Point origin, Sosage::Vector direction, std::vector<
         if (next_vertex == Graph::null_vertex())
           break;
         vertex = next_vertex;
-        origin = m_latest_graph[vertex].point;
+        origin = m_graph[vertex].point;
         out.push_back(origin);
       }
     }
@@ -616,14 +773,14 @@ void Ground_map::find_path (Point origin, Sosage::Vector direction, std::vector<
       }
       else
       {
-        GVertex source = m_latest_graph.source(edge);
-        GVertex target = m_latest_graph.target(edge);
-        Sosage::Vector dir (m_latest_graph[source].point, m_latest_graph[target].point);
+        GVertex source = m_graph.source(edge);
+        GVertex target = m_graph.target(edge);
+        Sosage::Vector dir (m_graph[source].point, m_graph[target].point);
         double scalar = dir * direction;
         if (scalar == 0) // edge exactly perpendicular to direction, stop
           break;
         vertex = (scalar > 0 ? target : source);
-        origin = m_latest_graph[vertex].point;
+        origin = m_graph[vertex].point;
         out.push_back(origin);
       }
     }
@@ -651,16 +808,14 @@ double Ground_map::z_at_point (const Point& p) const
 {
   int x = p.X();
   int y = p.Y();
-  if (x >= m_image->w) x = m_image->w - 1;
+  if (x >= m_width) x = m_width - 1;
   if (x < 0) x = 0;
-  if (y >= m_image->h) y = m_image->h - 1;
+  if (y >= m_height) y = m_height - 1;
   if (y < 0) y = 0;
 
-  std::array<unsigned char, 3> c = Core::Graphic::get_color (m_image, x, y);
-
   unsigned char red = 0;
-  if (c[0] == c[1] && c[0] == c[2])
-    red = c[0];
+  if (is_ground(x, y))
+    red = depth(x, y);
   else
   {
     Neighbor_query query = closest_simplex (p);
@@ -686,10 +841,7 @@ bool Ground_map::is_ground_point (const Point& p) const
   int x = p.X();
   int y = p.Y();
   // Out of bound points can't be ground
-  if (x >= m_image->w || y >= m_image->h || x < 0 || y < 0)
-    return false;
-  std::array<unsigned char, 3> c = Core::Graphic::get_color (m_image, x, y);
-  return (c[0] == c[1] && c[0] == c[2]);
+  return is_ground (x, y);
 }
 
 Ground_map::Neighbor_query Ground_map::closest_simplex (const Point& p) const
@@ -746,75 +898,166 @@ Ground_map::Neighbor_query Ground_map::closest_simplex (const Point& p) const
   return {vertex, edge, min_dist, point};
 }
 
+void Ground_map::dijkstra (GVertex vorigin)
+{
+  // Djikstra on base graph + overlay, buffers are reused between queries
+  std::size_t nb_vertices = m_graph.num_vertices() + 2;
+  m_overlay.dist.assign (nb_vertices, std::numeric_limits<double>::max());
+  m_overlay.parent.assign (nb_vertices, Graph::null_vertex());
+
+  auto& todo = m_overlay.todo;
+  todo.clear();
+  m_overlay.dist[std::size_t(vorigin)] = 0;
+  todo.push_back (std::make_pair (-0., vorigin));
+
+  while (!todo.empty())
+  {
+    std::pop_heap (todo.begin(), todo.end());
+    double current_dist = -todo.back().first;
+    GVertex current = todo.back().second;
+    todo.pop_back();
+
+    if (m_overlay.dist[std::size_t(current)] < current_dist) // outdated item
+      continue;
+
+    for_each_neighbor
+      (current, [&](GVertex next)
+       {
+         double dist = current_dist + distance (point(current), point(next));
+         if (dist < m_overlay.dist[std::size_t(next)])
+         {
+           m_overlay.dist[std::size_t(next)] = dist;
+           debug_gm << "Update Dist[" << next << "] = " << dist << std::endl;
+           m_overlay.parent[std::size_t(next)] = current;
+           debug_gm << "Update Parent[" << next << "] = " << current << std::endl;
+           todo.push_back (std::make_pair (-dist, next));
+           std::push_heap (todo.begin(), todo.end());
+         }
+       });
+  }
+}
+
 void Ground_map::shortest_path (GVertex vorigin, GVertex vtarget,
                                 std::vector<Point>& out)
 {
-  // Djikstra
-  std::priority_queue<std::pair<double, GVertex> > todo;
+  dijkstra (vorigin);
 
-  std::vector<GVertex> parent (m_latest_graph.vertices().size(), Graph::null_vertex());
-  
-  for (GVertex v : m_latest_graph.vertices())
+  std::size_t first = out.size();
+  while (vtarget != vorigin)
   {
-    double dist = std::numeric_limits<double>::max();
-    if (v == vorigin)
-      dist = 0;
-    m_latest_graph[v].dist = dist;
-    todo.push (std::make_pair(-dist, v));
-    debug_gm << "Dist[" << v << "] = " << dist << std::endl;
+    const GVertex& parent = m_overlay.parent[std::size_t(vtarget)];
+    debug_gm << "Going back from " << vtarget << " to " << parent << std::endl;
+    check (parent != Graph::null_vertex(), "Node has no parent");
+    out.push_back (point(vtarget));
+    vtarget = parent;
   }
+  std::reverse (out.begin() + first, out.end());
+}
 
-  while (!todo.empty())
-  {
-    double current_dist = -todo.top().first;
-    GVertex current = todo.top().second;
-    todo.pop();
+void Ground_map::precompute_shortest_paths()
+{
+  SOSAGE_TIMER_START(Ground_map__precompute_shortest_paths);
 
-    if (m_latest_graph[current].dist < current_dist) // outdated item
-      continue;
-    
-    for (std::size_t i = 0; i < m_latest_graph.incident_edges(current).size(); ++ i)
+  reset_overlay();
+  std::size_t nb_vertices = m_graph.num_vertices();
+  check (nb_vertices < std::size_t(no_next_hop), "Too many vertices to precompute shortest paths");
+
+  m_distances.assign (nb_vertices * nb_vertices, std::numeric_limits<float>::max());
+  m_next_hops.assign (nb_vertices * nb_vertices, no_next_hop);
+
+  // Graph is undirected: parent of a vertex in the tree rooted at
+  // target is the next hop from this vertex to target
+  for (GVertex target : m_graph.vertices())
+  {
+    dijkstra (target);
+    for (GVertex v : m_graph.vertices())
     {
-      GVertex next = m_latest_graph.incident_vertex(current,i);
-      double dist = current_dist + distance (m_latest_graph[current].point,
-                                             m_latest_graph[next].point);
-      if (dist < m_latest_graph[next].dist)
-      {
-        m_latest_graph[next].dist = dist;
-        debug_gm << "Update Dist[" << next << "] = " << dist << std::endl;
-        parent[std::size_t(next)] = current;
-        debug_gm << "Update Parent[" << next << "] = " << current << std::endl;
-        todo.push (std::make_pair (-dist, next));
-      }
+      std::size_t idx = std::size_t(v) * nb_vertices + std::size_t(target);
+      if (m_overlay.dist[std::size_t(v)] == std::numeric_limits<double>::max())
+        continue;
+      m_distances[idx] = float(m_overlay.dist[std::size_t(v)]);
+      if (v != target)
+        m_next_hops[idx] = (unsigned short)(m_overlay.parent[std::size_t(v)]);
     }
   }
-  
-  std::vector<Point> path;
-  while (vtarget != vorigin)
+
+  SOSAGE_TIMER_STOP(Ground_map__precompute_shortest_paths);
+}
+
+void Ground_map::precomputed_shortest_path (GVertex vorigin, GVertex vtarget,
+                                            std::vector<Point>& out)
+{
+  // Only origin and target are connected to the base graph: pick the
+  // best pair of entry/exit vertices using the precomputed distances
+  std::size_t nb_vertices = m_graph.num_vertices();
+
+  auto for_each_entry = [&](std::size_t idx, const auto& functor)
   {
-    debug_gm << "Going back from " << vtarget << " to " << parent[vtarget] << std::endl;
-    check (parent[vtarget] != Graph::null_vertex(), "Node has no parent");
-    path.push_back (m_latest_graph[vtarget].point);
-    vtarget = parent[std::size_t(vtarget)];
+    GVertex v = m_overlay.endpoints[idx];
+    if (!is_overlay_vertex(v))
+      functor (v, 0.);
+    for (GVertex n : m_overlay.links[idx])
+      if (!is_overlay_vertex(n))
+        functor (n, distance (point(v), point(n)));
+  };
+
+  double best = std::numeric_limits<double>::max();
+  GVertex entry = Graph::null_vertex();
+  GVertex exit = Graph::null_vertex();
+  for_each_entry
+    (0, [&](GVertex a, double da)
+     {
+       for_each_entry
+         (1, [&](GVertex b, double db)
+          {
+            float dab = m_distances[std::size_t(a) * nb_vertices + std::size_t(b)];
+            if (dab == std::numeric_limits<float>::max())
+              return;
+            double dist = da + dab + db;
+            if (dist < best)
+            {
+              best = dist;
+              entry = a;
+              exit = b;
+            }
+          });
+     });
+  check (entry != Graph::null_vertex(), "No path found");
+  debug_gm << "Precomputed path enters at " << entry << " and exits at " << exit << std::endl;
+
+  if (entry != vorigin)
+    out.push_back (point(entry));
+  for (GVertex v = entry; v != exit; )
+  {
+    v = GVertex(m_next_hops[std::size_t(v) * nb_vertices + std::size_t(exit)]);
+    out.push_back (point(v));
   }
-  std::copy (path.rbegin(), path.rend(),
-             std::back_inserter (out));
+  if (exit != vtarget)
+    out.push_back (point(vtarget));
 }
 
-bool Ground_map::intersects_border (const Graph& g,
-                                    const Segment& seg,
+bool Ground_map::intersects_border (const Segment& seg,
                                     const Edge_condition& condition) const
 {
-  for (GEdge e : g.edges())
-  {
-    if (!g.is_valid(e) || !g[e].border || condition(e))
-      continue;
-    Segment eseg (g[g.source(e)].point,
-                  g[g.target(e)].point);
-    if (intersect(seg, eseg))
-      return true;
-  }
-  return false;
+  bool out = false;
+  for_each_cell (seg.source(), seg.target(),
+                 [&](std::size_t cell) -> bool
+                 {
+                   for (GEdge e : m_grid[cell])
+                   {
+                     if (condition(e))
+                       continue;
+                     Segment eseg (m_graph[m_graph.source(e)].point,
+                                   m_graph[m_graph.target(e)].point);
+                     if (intersect(seg, eseg))
+                     {
+                       out = true;
+                       return false;
+                     }
+                   }
+                   return true;
+                 });
+  return out;
 }
 
 Ground_map::Neighbor_query Ground_map::closest_intersected_edge (const Point& p,
@@ -824,25 +1067,31 @@ Ground_map::Neighbor_query Ground_map::closest_intersected_edge (const Point& p,
   Segment seg (p, p + m_radius * direction);
   Neighbor_query out;
 
-  const Graph& g = m_latest_graph;
-  for (GEdge e : g.edges())
-  {
-    if (!g.is_valid(e) || !g[e].border || condition(e))
-      continue;
-    Segment eseg (g[g.source(e)].point,
-                  g[g.target(e)].point);
-    if (intersect(seg, eseg))
-    {
-      Point inter = intersection(seg, eseg);
-      double dist = distance(p, inter);
-      if (dist < out.dist)
-      {
-        out.edge = e;
-        out.dist = dist;
-        out.point = inter;
-      }
-    }
-  }
+  const Graph& g = m_graph;
+  for_each_cell (seg.source(), seg.target(),
+                 [&](std::size_t cell) -> bool
+                 {
+                   for (GEdge e : m_grid[cell])
+                   {
+                     if (e == out.edge || condition(e))
+                       continue;
+                     Segment eseg (g[g.source(e)].point,
+                                   g[g.target(e)].point);
+                     if (intersect(seg, eseg))
+                     {
+                       Point inter = intersection(seg, eseg);
+                       double dist = distance(p, inter);
+                       // Edges come in cell order, keep lowest index on ties
+                       if (dist < out.dist || (dist == out.dist && e < out.edge))
+                       {
+                         out.edge = e;
+                         out.dist = dist;
+                         out.point = inter;
+                       }
+                     }
+                   }
+                   return true;
+                 });
 
   if (out.edge == Graph::null_edge())
     return Neighbor_query();
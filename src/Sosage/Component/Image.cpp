@@ -69,9 +69,15 @@ Image::Image (const std::string& entity, const std::string& component, std::shar
 
 }
 
-void Image::compose_with (const std::shared_ptr<Image>& other)
+// Caps (optional) are shared, the middle is a solid rectangle
+Image::Image (const std::string& entity, const std::string& component,
+              std::shared_ptr<Image> left, int w, int h, int r, int g, int b,
+              std::shared_ptr<Image> right)
+  : Base(entity, component), m_origin(0,0), m_z(Config::interface_depth), m_on(true),
+    m_collision(UNCLICKABLE), m_scaling(1), m_highlight_alpha(0), m_alpha(255)
 {
-  m_core = Core::Graphic::compose ({m_core, other->m_core});
+  m_core = Core::Graphic::create_slices ((left ? left->m_core : Core::Graphic::Image()), w, h, r, g, b,
+                                         (right ? right->m_core : Core::Graphic::Image()));
 }
 
 void Image::set_collision (const Collision_type& collision)
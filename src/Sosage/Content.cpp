@@ -70,6 +70,7 @@ Content::Content()
           "value" };
 
   m_data.resize(reserved_components.size() + 1);
+  m_revisions.resize(m_data.size(), 0);
   std::size_t idx = 1;
   for (const auto& c : reserved_components)
     m_map_component.insert (std::make_pair(c, idx ++));
@@ -85,10 +86,14 @@ void Content::clear()
   for (std::size_t i = 0; i < NUMBER_OF_KEYS; ++ i)
     m_fast_access_components[i] = nullptr;
   m_data.clear();
+  for (std::size_t& r : m_revisions)
+    ++ r;
 }
 
 void Content::clear (const std::function<bool(Component::Handle)>& filter)
 {
+  for (std::size_t& r : m_revisions)
+    ++ r;
   for (auto& hmap : m_data)
   {
     Component::Handle_map& old_map = hmap;
@@ -115,20 +120,56 @@ Component::Component_map::const_iterator Content::end() const
   return m_data.end();
 }
 
-Component::Handle_set Content::components (const std::string& s)
+Component::Handle_set Content::components (const Symbol& s)
 {
-  return Component::Handle_set(handle_map(s));
+  std::size_t idx = component_index(s);
+  return Component::Handle_set(m_data[idx], m_revisions[idx]);
 }
 
-bool Content::remove (const std::string& entity, const std::string& component, bool optional)
+std::size_t Content::revision (const Symbol& component)
+{
+  return m_revisions[component_index(component)];
+}
+
+std::size_t Content::reserve (const Symbol& component)
+{
+  auto inserted = m_map_component.insert (std::make_pair (component, m_data.size()));
+  if (!inserted.second)
+    return inserted.first->second;
+
+  Component::Handle_map kept;
+  Component::Handle_map moved;
+  for (const auto& c : m_data[0])
+    if (c.first.second == component)
+      moved.insert(c);
+    else
+      kept.insert(c);
+  m_data[0].swap (kept);
+  m_data.emplace_back();
+  m_data.back().swap (moved);
+
+  // Systems that kept a revision of the default storage must update
+  ++ m_revisions[0];
+  m_revisions.push_back (m_revisions[0]);
+  return inserted.first->second;
+}
+
+void Content::compact()
+{
+  for (Component::Handle_map& hmap : m_data)
+    hmap.compact();
+}
+
+bool Content::remove (const Symbol& entity, const Symbol& component, bool optional)
 {
   Component::Handle_map& hmap = handle_map(component);
   Component::Handle_map::iterator iter = hmap.find(Component::Id(entity, component));
   if (optional && iter == hmap.end())
     return false;
   
-  check (iter != hmap.end(), "Id " + entity + ":" + component + " doesn't exist");
+  check (iter != hmap.end(), "Id " + entity.str() + ":" + component.str() + " doesn't exist");
   hmap.erase(iter);
+  ++ m_revisions[component_index(component)];
   return true;
 }
 
@@ -137,12 +178,12 @@ bool Content::remove (Component::Handle handle, bool optional)
   return remove (handle->entity(), handle->component(), optional);
 }
 
-void Content::emit (const std::string& entity, const std::string& component)
+void Content::emit (const Symbol& entity, const Symbol& component)
 {
   set<Component::Signal>(entity, component);
 }
 
-bool Content::receive (const std::string& entity, const std::string& component)
+bool Content::receive (const Symbol& entity, const Symbol& component)
 {
   count_access(entity, component);
   count_request();
@@ -155,24 +196,30 @@ bool Content::receive (const std::string& entity, const std::string& component)
   if (!Component::cast<Component::Signal>(iter->second))
     return false;
   hmap.erase (iter);
+  ++ m_revisions[component_index(component)];
   return true;
 }
 
-bool Content::signal (const std::string& entity, const std::string& component)
+bool Content::signal (const Symbol& entity, const Symbol& component)
 {
   return bool(request<Component::Signal>(entity, component));
 }
 
-Component::Handle_map& Content::handle_map (const std::string& s)
+std::size_t Content::component_index (const Symbol& s)
 {
   auto iter = m_map_component.find(s);
   if (iter == m_map_component.end())
   {
     SOSAGE_COUNT (Content__components_default);
-    return m_data[0];
+    return 0;
   }
   SOSAGE_COUNT (Content__components_special);
-  return m_data[iter->second];
+  return iter->second;
+}
+
+Component::Handle_map& Content::handle_map (const Symbol& s)
+{
+  return m_data[component_index(s)];
 }
 
 
@@ -199,9 +246,9 @@ void Content::count_get()
 
 #ifdef SOSAGE_PROFILE
 
-void Content::count_access (const std::string& entity, const std::string& component)
+void Content::count_access (const Symbol& entity, const Symbol& component)
 {
-  auto inserted = m_access_count.insert (std::make_pair (entity + ":" + component, 1));
+  auto inserted = m_access_count.insert (std::make_pair (Component::Id(entity, component), 1));
   if (!inserted.second)
     inserted.first->second ++;
 }
@@ -210,8 +257,8 @@ void Content::display_access()
 {
   std::vector<std::pair<std::string, std::size_t> > sorted;
   sorted.reserve (m_access_count.size());
-  std::copy (m_access_count.begin(), m_access_count.end(),
-             std::back_inserter (sorted));
+  for (const auto& a : m_access_count)
+    sorted.emplace_back (a.first.first.str() + ":" + a.first.second.str(), a.second);
   auto end = std::partition
              (sorted.begin(), sorted.end(),
               [](const auto& p) -> bool { return isupper(p.first[0]); });
@@ -228,7 +275,7 @@ void Content::display_access()
 
 #else
 
-void Content::count_access (const std::string&, const std::string&) { }
+void Content::count_access (const Symbol&, const Symbol&) { }
 void Content::display_access () { }
 
 #endif
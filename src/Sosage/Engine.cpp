@@ -51,7 +51,9 @@
 #include <Sosage/Utils/Asset_manager.h>
 #include <Sosage/Utils/error.h>
 #include <Sosage/Utils/profiling.h>
+#include <Sosage/Utils/Worker_pool.h>
 
+#include <algorithm>
 #include <ctime>
 
 #ifdef SOSAGE_EMSCRIPTEN
@@ -63,7 +65,7 @@ namespace Sosage
 
 // Global variables
 std::string Asset_manager::folder_name = "";
-std::vector<Buffer> Asset_manager::buffers;
+std::vector<Package_buffer> Asset_manager::buffers;
 Package_asset_map Asset_manager::package_asset_map;
 double Config::interface_scale = 1;
 #ifdef SOSAGE_DEBUG_BUFFER
@@ -99,6 +101,9 @@ Engine::~Engine()
   // Clear content before shutting down systems
   m_content.clear();
 
+  // Systems (and their worker jobs) are gone, packages can be released
+  Asset_manager::shutdown();
+
   Steam::shutdown();
 }
 
@@ -158,6 +163,10 @@ bool Engine::run (const std::string& folder_name)
   m_systems.push_back (graphic);
   m_systems.push_back (time);
 
+  m_schedule.resize (m_systems.size());
+  for (std::size_t i = 0; i < m_systems.size(); ++ i)
+    m_schedule[i].system = m_systems[i];
+
   file_io->read_config();
 
   graphic->init(); // init graphics
@@ -195,6 +204,7 @@ bool Engine::run (const std::string& folder_name)
   if (m_content.receive("Game", "save"))
     file_io->write_savefile();
 
+  m_schedule.clear();
   m_systems.clear();
   interface.reset(); // Clear interface before SDL is exited
   m_content.clear();
@@ -204,12 +214,100 @@ bool Engine::run (const std::string& folder_name)
 
 bool Engine::run()
 {
+  m_content.compact();
+
+#if defined(SOSAGE_PROFILE) || defined(SOSAGE_LOG_CONTENT)
+  // Timers and access counters are not thread-safe
   for (System::Handle system : m_systems)
     system->run();
+#else
+  run_systems();
+#endif
   Steam::run();
   return !m_content.receive("Game", "exit");
 }
 
+void Engine::run_systems()
+{
+  // Declared access may change from one frame to another
+  for (Scheduled_system& s : m_schedule)
+  {
+    s.access.clear();
+    s.system->declare_access (s.access);
+    s.reads.clear();
+    s.writes.clear();
+    for (const Symbol& c : s.access.reads)
+      s.reads.push_back (m_content.reserve(c));
+    for (const Symbol& c : s.access.writes)
+      s.writes.push_back (m_content.reserve(c));
+  }
+
+  for (std::size_t i = 0; i < m_schedule.size(); ++ i)
+  {
+    m_schedule[i].dependencies.clear();
+    for (std::size_t j = 0; j < i; ++ j)
+      if (conflict (m_schedule[j], m_schedule[i]))
+        m_schedule[i].dependencies.push_back (j);
+  }
+
+  bool threads = (workers().size() != 0);
+  for (Scheduled_system& s : m_schedule)
+  {
+    for (std::size_t d : s.dependencies)
+      wait_for_system (m_schedule[d]);
+
+    if (threads && !s.access.main_thread)
+    {
+      auto claimed = std::make_shared<std::atomic<bool> >(false);
+      System::Handle system = s.system;
+      s.claimed = claimed;
+      s.done = workers().submit ([claimed, system]()
+                                 {
+                                   if (!claimed->exchange(true))
+                                     system->run();
+                                 });
+      s.pending = true;
+    }
+    else
+      s.system->run();
+  }
+
+  for (Scheduled_system& s : m_schedule)
+    wait_for_system (s);
+}
+
+void Engine::wait_for_system (Scheduled_system& s)
+{
+  if (!s.pending)
+    return;
+  s.pending = false;
+
+  // Workers may be busy prefetching rooms: if none started the
+  // system yet, run it here instead of waiting
+  if (!s.claimed->exchange(true))
+    s.system->run();
+  else
+    s.done.get();
+}
+
+bool Engine::conflict (const Scheduled_system& a, const Scheduled_system& b)
+{
+  if (a.access.everything || b.access.everything)
+    return true;
+
+  auto intersect = [](const std::vector<std::size_t>& x, const std::vector<std::size_t>& y) -> bool
+  {
+    for (std::size_t i : x)
+      if (std::find (y.begin(), y.end(), i) != y.end())
+        return true;
+    return false;
+  };
+
+  return (intersect (a.writes, b.reads)
+          || intersect (a.writes, b.writes)
+          || intersect (a.reads, b.writes));
+}
+
 void Engine::handle_cmdline_args (int argc, char** argv)
 {
   for (int i = 1; i < argc; ++ i)
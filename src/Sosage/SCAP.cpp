@@ -3,24 +3,53 @@
 #include <Sosage/Utils/asset_packager.h>
 
 std::string Sosage::Asset_manager::folder_name = "";
-std::vector<Sosage::Buffer> Sosage::Asset_manager::buffers;
+std::vector<Sosage::Package_buffer> Sosage::Asset_manager::buffers;
 Sosage::Package_asset_map Sosage::Asset_manager::package_asset_map;
 
+void usage (const char* name)
+{
+  std::cerr << "Usage: " << name << " [input_folder] [output_folder]" << std::endl;
+  std::cerr << "Usage: " << name << " [input_folder] [output_folder] -d to decompress" << std::endl;
+  std::cerr << "Options: --deterministic to compress files in sorted order" << std::endl;
+  std::cerr << "         --cache=[folder] to reuse compressed files from previous builds" << std::endl;
+  std::cerr << "                          (entries not used by the build are removed from it," << std::endl;
+  std::cerr << "                          delete the folder to clean it entirely)" << std::endl;
+}
+
 int main (int argc, char** argv)
 {
   if (argc < 3)
   {
-    std::cerr << "Usage: " << argv[0] << " [input_folder] [output_folder]" << std::endl;
-    std::cerr << "Usage: " << argv[0] << " [input_folder] [output_folder] -d to decompress" << std::endl;
+    usage (argv[0]);
     return EXIT_SUCCESS;
   }
 
   std::string root = argv[1];
   std::string out = argv[2];
-  if (argc == 4)
+  bool decompress = false;
+  bool deterministic = false;
+  std::string cache = "";
+  for (int i = 3; i < argc; ++ i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--deterministic")
+      deterministic = true;
+    else if (arg.find("--cache=") == 0)
+      cache = arg.substr(8);
+    else if (arg == "-d")
+      decompress = true;
+    else
+    {
+      std::cerr << "Unknown option " << arg << std::endl;
+      usage (argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (decompress)
     Sosage::SCAP::decompile_package (root, out);
   else
-    Sosage::SCAP::compile_package (root, out);
+    Sosage::SCAP::compile_package (root, out, deterministic, cache);
 
   return EXIT_SUCCESS;
 }
@@ -78,8 +78,19 @@ void Animation::run()
     return;
   }
 
-  for (std::size_t i = m_frame_id; i < new_frame_id; ++ i)
-    run_animation_frame();
+  // After a hitch, late frames are caught up within a bounded budget,
+  // older ones are simply dropped
+  std::size_t nb_frames = new_frame_id - m_frame_id;
+  if (nb_frames > Config::animation_max_catch_up)
+  {
+    debug << "Dropping " << nb_frames - Config::animation_max_catch_up
+          << " late animation frame(s)" << std::endl;
+    nb_frames = Config::animation_max_catch_up;
+  }
+
+  if (nb_frames > 1)
+    run_catch_up_frames (nb_frames - 1);
+  run_animation_frame();
   m_frame_id = new_frame_id;
   SOSAGE_TIMER_STOP(System_Animation__run);
 }
@@ -236,11 +247,46 @@ void Animation::run_animation_frame()
   m_just_started.clear();
 }
 
+void Animation::run_catch_up_frames (std::size_t nb_frames)
+{
+  SOSAGE_TIMER_START(System_Animation__run_catch_up_frames);
+
+  // Only gameplay-relevant steps are replayed: characters walking along
+  // their path and non-looping animations, which actions may wait for.
+  // Looping animations are purely cosmetic and skip late frames.
+  static std::vector<Component::Animation_handle> animations;
+  for (auto c : components("image"))
+    if (auto anim = C::cast<C::Animation>(c))
+      if (anim->on() && anim->playing() && !anim->loop())
+        animations.push_back(anim);
+
+  bool has_moved = false;
+  for (std::size_t i = 0; i < nb_frames; ++ i)
+  {
+    if (handle_paths())
+      has_moved = true;
+
+    for (C::Handle c : m_to_remove)
+      remove(c);
+    m_to_remove.clear();
+
+    for (const auto& animation : animations)
+      if (animation->on() && !animation->next_frame())
+        animation->on() = false;
+  }
+
+  if (has_moved)
+    update_camera_target();
+
+  animations.clear();
+  SOSAGE_TIMER_STOP(System_Animation__run_catch_up_frames);
+}
+
 void Animation::handle_character_lookat (bool in_new_room)
 {
   for (auto c : components("lookat"))
   {
-    const std::string& id = c->entity();
+    const Symbol& id = c->id().first;
     auto lookat = C::cast<C::Position>(c);
     debug << "lookat " << lookat->str() << std::endl;
     if (receive(id, "needs_rescale") || in_new_room)
@@ -276,7 +322,7 @@ void Animation::handle_animation_stops()
 {
   for (auto c : components("stop_talking"))
   {
-    const std::string& id = c->entity();
+    const Symbol& id = c->id().first;
     if (auto mhead = request<C::Position>(id + "_head_move", "position"))
     {
       mhead->set (Point (0, 0));
@@ -287,7 +333,7 @@ void Animation::handle_animation_stops()
 
   for (auto c : components("stop_walking"))
   {
-    const std::string& id = c->entity();
+    const Symbol& id = c->id().first;
     if (value<C::Boolean>(id , "walking"))
     {
       generate_random_idle_animation (id, is_walking_right(id));
@@ -298,7 +344,7 @@ void Animation::handle_animation_stops()
 
   for (auto c : components("stop_animation"))
   {
-    const std::string& id = c->entity();
+    const Symbol& id = c->id().first;
     debug << "stop_animation" << std::endl;
     if (request<C::Animation>(id + "_head", "image"))
     {
@@ -319,8 +365,6 @@ void Animation::handle_animation_stops()
 
 bool Animation::handle_moves()
 {
-  bool has_moved = false;
-
   for (auto c : components("move"))
     if (auto a = C::cast<C::Tuple<Point, Point, int, int, double, double>>(c))
     {
@@ -359,7 +403,12 @@ bool Animation::handle_moves()
       get<C::Image>(a->entity() , "image")->set_scale (scale);
     }
 
+  return handle_paths();
+}
 
+bool Animation::handle_paths()
+{
+  bool has_moved = false;
   for (auto c : components("path"))
     if (auto path = C::cast<C::Path>(c))
     {
@@ -378,14 +427,14 @@ void Animation::handle_animation_starts()
 {
   for (auto c : components("start_talking"))
   {
-    const std::string& id = c->entity();
+    const Symbol& id = c->id().first;
     generate_random_mouth_animation (id);
     m_to_remove.push_back(c);
   }
 
   for (auto c : components("start_animation"))
   {
-    const std::string& id = c->entity();
+    const Symbol& id = c->id().first;
     if (auto s = C::cast<C::Signal>(c))
     {
       auto anim = get<C::Animation>(id , "image");
@@ -397,7 +446,7 @@ void Animation::handle_animation_starts()
     else
     {
       auto anim = C::cast<C::String>(c);
-      const std::string& id = c->entity();
+      const Symbol& id = c->id().first;
       debug << "start_animation" << std::endl;
       generate_animation (id, anim->value());
       m_to_remove.push_back (c);
@@ -412,7 +461,7 @@ void Animation::handle_state_changes()
 {
   for (auto c : components("pause"))
   {
-    const std::string& id = c->entity();
+    const Symbol& id = c->id().first;
     get<C::Animation>(id, "image")->playing() = false;
     m_to_remove.push_back (c);
   }
@@ -428,7 +477,7 @@ void Animation::handle_state_changes()
   for (auto c : components("set_hidden"))
   {
     debug << "Set " << c->str() << " hidden" << std::endl;
-    const std::string& id = c->entity();
+    const Symbol& id = c->id().first;
     auto g = get<C::Group>(id , "group");
     g->apply<C::Image>([](auto img) { img->on() = false; });
     emit(id, "is_hidden");
@@ -438,7 +487,7 @@ void Animation::handle_state_changes()
   for (auto c : components("set_visible"))
   {
     debug << "Set " << c->str() << " visible" << std::endl;
-    const std::string& id = c->entity();
+    const Symbol& id = c->id().first;
     auto g = get<C::Group>(id , "group");
     g->apply<C::Image>([](auto img) { img->on() = true; });
     receive(id, "is_hidden");
@@ -491,7 +540,7 @@ bool Animation::run_loading()
   return true;
 }
 
-void Animation::place_and_scale_character(const std::string& id)
+void Animation::place_and_scale_character(const Symbol& id)
 {
   // If character has no skin ("fake" character), do nothing
   if (!request<C::Group>(id, "group"))
@@ -540,7 +589,7 @@ bool Animation::compute_movement_from_path (C::Path_handle path)
 {
   bool out = true;
 
-  std::string id = path->entity();
+  const Symbol& id = path->id().first;
   get<C::Boolean>(id , "walking")->set(true);
   auto abody = get<C::Animation>(id + "_body", "image");
   auto ahead = get<C::Animation>(id + "_head", "image");
@@ -600,7 +649,7 @@ bool Animation::compute_movement_from_path (C::Path_handle path)
   return out;
 }
 
-void Animation::set_move_animation (const std::string& id, const Vector& direction)
+void Animation::set_move_animation (const Symbol& id, const Vector& direction)
 {
   auto image = get<C::Animation>(id + "_body", "image");
   auto head = get<C::Animation>(id + "_head", "image");
@@ -642,7 +691,7 @@ void Animation::set_move_animation (const std::string& id, const Vector& directi
   }
 }
 
-void Animation::generate_random_idle_animation (const std::string& id, bool looking_right)
+void Animation::generate_random_idle_animation (const Symbol& id, bool looking_right)
 {
   // If character has no skin ("fake" character), do nothing
   if (!request<C::Group>(id, "group"))
@@ -652,7 +701,7 @@ void Animation::generate_random_idle_animation (const std::string& id, bool look
   generate_random_idle_head_animation (id, looking_right);
 }
 
-void Animation::generate_random_idle_head_animation (const std::string& id, bool looking_right)
+void Animation::generate_random_idle_head_animation (const Symbol& id, bool looking_right)
 {
   debug << "Generate random idle head animation for character \"" << id << "\"" << std::endl;
 
@@ -728,7 +777,7 @@ void Animation::generate_random_idle_head_animation (const std::string& id, bool
   }
 }
 
-void Animation::generate_random_idle_body_animation (const std::string& id, bool looking_right)
+void Animation::generate_random_idle_body_animation (const Symbol& id, bool looking_right)
 {
   debug << "Generate random idle body animation for character \"" << id << "\"" << std::endl;
 
@@ -786,7 +835,7 @@ void Animation::generate_random_idle_body_animation (const std::string& id, bool
   }
 }
 
-void Animation::generate_random_mouth_animation (const std::string& id)
+void Animation::generate_random_mouth_animation (const Symbol& id)
 {
   auto image = request<C::Animation>(id + "_mouth", "image");
   if (!image)
@@ -816,7 +865,7 @@ void Animation::generate_random_mouth_animation (const std::string& id)
   }
 }
 
-void Animation::generate_animation (const std::string& id, const std::string& anim)
+void Animation::generate_animation (const Symbol& id, const std::string& anim)
 {
   debug << "Generate animation \"" << anim << "\" for character \"" << id << "\"" << std::endl;
   get<C::Boolean>(id , "walking")->set(false);
@@ -838,7 +887,7 @@ void Animation::generate_animation (const std::string& id, const std::string& an
       index = int(i);
       break;
     }
-  check (index != -1, "No " + anim + " skin found for " + id);
+  check (index != -1, "No " + anim + " skin found for " + id.str());
 
   image->frames().push_back ({index, row_index, 1});
 }
@@ -867,7 +916,7 @@ void Animation::update_camera_target ()
   auto background = request<C::Image>("background", "image");
   if (!background)
     return;
-  const std::string& id = value<C::String>("Player", "name");
+  Symbol id = value<C::String>("Player", "name");
   int xbody = value<C::Position>(id + "_body", "position").X();
   double xcamera = value<C::Absolute_position>(CAMERA__POSITION).x();
 
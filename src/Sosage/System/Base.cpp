@@ -38,12 +38,19 @@ Base::~Base() { }
 
 void Base::init() { }
 
-Component::Handle_set Base::components (const std::string& s)
+void Base::declare_access (Access&) { }
+
+Component::Handle_set Base::components (const Symbol& s)
 {
   return m_content.components(s);
 }
 
-bool Base::remove (const std::string& entity, const std::string& component, bool optional)
+std::size_t Base::revision (const Symbol& s)
+{
+  return m_content.revision(s);
+}
+
+bool Base::remove (const Symbol& entity, const Symbol& component, bool optional)
 {
   return m_content.remove(entity, component, optional);
 }
@@ -53,17 +60,17 @@ bool Base::remove (Component::Handle handle, bool optional)
   return m_content.remove(handle, optional);
 }
 
-void Base::emit (const std::string& entity, const std::string& component)
+void Base::emit (const Symbol& entity, const Symbol& component)
 {
   m_content.emit (entity, component);
 }
 
-bool Base::receive (const std::string& entity, const std::string& component)
+bool Base::receive (const Symbol& entity, const Symbol& component)
 {
   return m_content.receive(entity, component);
 }
 
-bool Base::signal (const std::string& entity, const std::string& component)
+bool Base::signal (const Symbol& entity, const Symbol& component)
 {
   return m_content.signal(entity, component);
 }
@@ -81,7 +88,7 @@ const std::string& Base::locale (const std::string& line)
   return line;
 }
 
-const std::string& Base::locale_get (const std::string& entity, const std::string& component)
+const std::string& Base::locale_get (const Symbol& entity, const Symbol& component)
 {
   return locale (value<Component::String>(entity, component));
 }
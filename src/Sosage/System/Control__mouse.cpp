@@ -73,7 +73,7 @@ void Control::idle_mouse()
 
     // Can't combine with a goto
     if (source)
-      if (request<C::Boolean>(img->entity() + "_goto", "right"))
+      if (request<C::Boolean>(img->id().first + "_goto", "right"))
         return false;
     return true;
   });
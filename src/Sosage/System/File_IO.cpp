@@ -63,6 +63,10 @@ namespace C = Component;
 
 File_IO::File_IO (Content& content)
   : Base (content)
+  , m_prefetch_cancelled (std::make_shared<std::atomic<bool> >(false))
+  , m_prefetch_needed (false)
+  , m_nb_room_changes (0)
+  , m_nb_prefetch_hits (0)
 {
   INIT_DISPATCHER("actions", read_action);
   INIT_DISPATCHER("animations", read_animation);
@@ -94,10 +98,14 @@ void File_IO::run()
   if (auto new_room = request<C::String>("Game", "new_room"))
   {
     receive ("Time", "speedup");
+    stop_prefetching (new_room->value());
     read_room (new_room->value());
     remove ("Game", "new_room");
     emit ("Game", "clear_notifications");
+    find_adjacent_rooms();
   }
+  else if (m_prefetch_needed && status()->is(IDLE))
+    prefetch_adjacent_rooms();
 
   if (receive("Game", "save"))
     write_savefile();
@@ -188,7 +196,10 @@ void File_IO::clean_content()
     read_init_global_items (input);
   }
 
+  // Sound system may run concurrently with the Graphic system that
+  // consumes the signal, so sound managers are cleared right away
   emit ("Game", "clear_managers");
+  Core::Sound::clear_managers();
   emit ("Dialog", "clean");
 }
 
@@ -594,6 +605,10 @@ void File_IO::read_init ()
   Core::File_IO input ("data/init.yaml");
   input.parse();
 
+  // Global assets are kept in memory for the whole game
+  Core::Graphic::pin_new_resources (true);
+  Core::Sound::pin_new_resources (true);
+
   read_init_general (input);
   read_init_achievement (input);
   read_init_cursor (input);
@@ -602,6 +617,10 @@ void File_IO::read_init ()
   read_init_functions (input);
   read_init_global_items (input);
   read_init_text_defaults (input);
+  read_init_preloaded_sounds (input);
+
+  Core::Graphic::pin_new_resources (false);
+  Core::Sound::pin_new_resources (false);
 
   set<C::String>("Game", "init_new_room", input["load"][0].string());
   set<C::String>("Game", "init_new_room_origin", input["load"][1].string());
@@ -766,6 +785,18 @@ void File_IO::read_init_inventory (const Core::File_IO& input)
   chamfer_img->z() = Config::interface_depth;
 }
 
+void File_IO::read_init_preloaded_sounds (const Core::File_IO& input)
+{
+  // Sounds used in many rooms are decoded once and stay in cache
+  if (!input.has("preload_sounds"))
+    return;
+  for (std::size_t i = 0; i < input["preload_sounds"].size(); ++ i)
+  {
+    std::string sound = input["preload_sounds"][i].string("sounds", "effects", "ogg");
+    Core::Sound::load_sound (sound);
+  }
+}
+
 void File_IO::read_init_interface (const Core::File_IO& input)
 {
   std::string click_sound = input["click_sound"].string("sounds", "effects", "ogg");
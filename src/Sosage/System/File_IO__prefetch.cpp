@@ -0,0 +1,167 @@
+/*
+  [src/Sosage/System/File_IO__prefetch.cpp]
+  Prefetches rooms reachable from the current one.
+
+  =====================================================================
+
+  This file is part of SOSAGE.
+
+  SOSAGE is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SOSAGE is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with SOSAGE.  If not, see <https://www.gnu.org/licenses/>.
+
+  =====================================================================
+
+  Author(s): Simon Giraudot <sosage@ptilouk.net>
+*/
+
+#include <Sosage/Component/Action.h>
+#include <Sosage/Component/Status.h>
+#include <Sosage/System/File_IO.h>
+#include <Sosage/Utils/Asset_cache.h>
+#include <Sosage/Utils/Asset_manager.h>
+#include <Sosage/Utils/profiling.h>
+#include <Sosage/Utils/Worker_pool.h>
+
+#include <unordered_set>
+
+namespace Sosage::System
+{
+
+namespace C = Component;
+
+void File_IO::find_adjacent_rooms()
+{
+  std::string current = value<C::String>("Game", "current_room");
+
+  // Room changes are all done through "load" steps of actions
+  std::unordered_set<std::string> rooms;
+  m_adjacent_rooms.clear();
+  for (const auto& hmap : m_content)
+    for (const auto& h : hmap)
+      if (auto action = C::cast<C::Action>(h.second))
+        for (const C::Action::Step& s : *action)
+          if (s.function() == "load" && !s.args().empty() && s.args()[0] != current
+              && rooms.insert(s.args()[0]).second)
+            m_adjacent_rooms.push_back (s.args()[0]);
+
+  debug << "Room " << current << " leads to " << m_adjacent_rooms.size() << " room(s)" << std::endl;
+  m_prefetch_needed = Asset_manager::packaged() && !m_adjacent_rooms.empty();
+}
+
+void File_IO::prefetch_adjacent_rooms()
+{
+  m_prefetch_needed = false;
+  m_prefetch_cancelled = std::make_shared<std::atomic<bool> >(false);
+
+  std::vector<std::string> sections;
+  for (const auto& d : m_dispatcher)
+    sections.push_back (d.first);
+
+  for (const std::string& room : m_adjacent_rooms)
+  {
+    if (contains (m_prefetched_rooms, room))
+      continue;
+
+    auto cancelled = m_prefetch_cancelled;
+    m_prefetched_rooms.insert
+        (std::make_pair (room, workers().submit ([room, sections, cancelled]() -> bool
+    {
+      // Collect YAML files of the room and warm them up
+      std::vector<std::string> files = { "data/rooms/" + room + ".yaml" };
+      std::unordered_set<std::string> values;
+      for (std::size_t f = 0; f < files.size() && !*cancelled; ++ f)
+      {
+        Asset_manager::prefetch (files[f]);
+        Core::File_IO input (files[f]);
+        if (!input.parse())
+          continue;
+
+        std::vector<const Core::File_IO::Node*> todo = { &input.root() };
+        while (!todo.empty())
+        {
+          const Core::File_IO::Node* node = todo.back();
+          todo.pop_back();
+          if (node->value != "")
+            values.insert (node->value);
+          for (const auto& m : node->map)
+            todo.push_back (m.second.get());
+          for (const auto& v : node->vec)
+            todo.push_back (v.get());
+        }
+
+        // External files of the room itself
+        if (f == 0)
+          for (const std::string& section : sections)
+            if (input.has(section))
+              for (std::size_t i = 0; i < input[section].size(); ++ i)
+                if (input[section][i].string() != "")
+                  files.push_back ("data/" + section + "/" + input[section][i].string() + ".yaml");
+      }
+
+      // Any value that matches an existing asset is decompressed in cache
+      for (const std::string& v : values)
+        for (const std::string& folder : Config::prefetch_folders)
+          for (const std::string& extension : Config::prefetch_extensions)
+          {
+            if (*cancelled)
+              return false;
+            std::string fname = folder + "/" + v + extension;
+            if (Asset_manager::exists (fname))
+              Asset_manager::prefetch (fname);
+          }
+
+      debug << "Room " << room << " prefetched (cache = "
+            << Asset_cache::size() / (1024 * 1024) << "MB)" << std::endl;
+      return !*cancelled;
+    }).share()));
+  }
+}
+
+File_IO::~File_IO()
+{
+  // Jobs read packages, which are unmapped on shutdown
+  *m_prefetch_cancelled = true;
+  for (const auto& p : m_prefetched_rooms)
+    p.second.wait();
+}
+
+void File_IO::stop_prefetching (const std::string& new_room)
+{
+  // Pending jobs will return right away
+  *m_prefetch_cancelled = true;
+  m_prefetch_needed = false;
+
+  auto is_done = [](const std::shared_future<bool>& f) -> bool
+  {
+    return (f.wait_for (std::chrono::seconds(0)) == std::future_status::ready) && f.get();
+  };
+
+  ++ m_nb_room_changes;
+  auto iter = m_prefetched_rooms.find (new_room);
+  if (iter != m_prefetched_rooms.end() && is_done (iter->second))
+    ++ m_nb_prefetch_hits;
+
+  debug << "Prefetch hits: " << m_nb_prefetch_hits << "/" << m_nb_room_changes
+        << " room changes, " << Asset_cache::hits() << " asset hits, "
+        << Asset_cache::misses() << " asset misses" << std::endl;
+
+  // Interrupted prefetches (and the new room, that may be evicted from
+  // cache later on) will be done again if needed
+  for (auto it = m_prefetched_rooms.begin(); it != m_prefetched_rooms.end(); )
+    if (it->first == new_room || !is_done (it->second))
+      it = m_prefetched_rooms.erase(it);
+    else
+      ++ it;
+}
+
+} // namespace Sosage::System
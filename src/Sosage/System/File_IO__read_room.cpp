@@ -47,6 +47,7 @@
 #include <Sosage/Utils/conversions.h>
 #include <Sosage/Utils/helpers.h>
 #include <Sosage/Utils/profiling.h>
+#include <Sosage/Utils/Worker_pool.h>
 
 namespace Sosage::System
 {
@@ -305,10 +306,22 @@ void File_IO::read_room (const std::string& file_name)
 
   callback->value()();
 
-  Core::File_IO input ("data/rooms/" + file_name + ".yaml");
-  input.parse();
+  // Parsing and decompression happen on workers while the main thread
+  // keeps the loading screen running, textures are uploaded at the end
+  Core::Graphic::start_deferred_loading();
 
-  callback->value()();
+  using File_IO_handle = std::shared_ptr<Core::File_IO>;
+  auto parse_file = [](const std::string& fname) -> File_IO_handle
+  {
+    auto out = std::make_shared<Core::File_IO>(fname);
+    bool okay = out->parse();
+    check(okay, "Can't open " + fname);
+    return out;
+  };
+
+  auto input_future = workers().submit ([&]() { return parse_file ("data/rooms/" + file_name + ".yaml"); });
+  File_IO_handle input_handle = wait_for (input_future, callback->value());
+  const Core::File_IO& input = *input_handle;
 
   std::string name = input["name"].string(); // unused so far
 
@@ -321,6 +334,15 @@ void File_IO::read_room (const std::string& file_name)
     auto background_img
         = set<C::Image>("background", "image", background, 0, BOX);
   }
+
+  // Ground maps are built by a worker and only set once the rest of the room is read
+  std::vector<std::tuple<std::string, std::string, int, int> > ground_maps;
+  auto build_ground_map = [&](const std::string& component, const std::string& ground_map,
+                              int front_z, int back_z)
+  {
+    ground_maps.emplace_back (component, ground_map, front_z, back_z);
+  };
+
   if (input.has("ground_map"))
   {
     int front_z = input["front_z"].integer();
@@ -329,8 +351,7 @@ void File_IO::read_room (const std::string& file_name)
     {
       emit ("Player", "not_moved_yet");
       std::string ground_map = input["ground_map"].string("images", "backgrounds", "png");
-      set<C::Ground_map>("background", "ground_map", ground_map,
-                         front_z, back_z, callback->value());
+      build_ground_map ("ground_map", ground_map, front_z, back_z);
     }
     else
     {
@@ -339,24 +360,47 @@ void File_IO::read_room (const std::string& file_name)
         emit ("Player", "not_moved_yet");
 
         std::string ground_map = input["ground_map"][0].string("images", "backgrounds", "png");
-        set<C::Ground_map>("background", "ground_map", ground_map,
-                           front_z, back_z, callback->value());
+        build_ground_map ("ground_map", ground_map, front_z, back_z);
       }
       std::string sec_ground_map = input["ground_map"][1].string("images", "backgrounds", "png");
-      set<C::Ground_map>("background", "2nd_ground_map", sec_ground_map,
-                         front_z, back_z, callback->value());
+      build_ground_map ("2nd_ground_map", sec_ground_map, front_z, back_z);
     }
   }
   else
     // Just in case a garbage signal remains...
     receive("Player", "not_moved_yet");
 
+  auto ground_maps_future = workers().submit ([=]() -> std::vector<C::Ground_map_handle>
+  {
+    std::vector<C::Ground_map_handle> out;
+    for (const auto& g : ground_maps)
+      out.emplace_back (std::make_shared<C::Ground_map>
+                        ("background", std::get<0>(g), std::get<1>(g),
+                         std::get<2>(g), std::get<3>(g), []{}));
+    return out;
+  });
+
   callback->value()();
 
   set<C::Absolute_position>("background", "position", Point(0, 0), false);
 
+  // All external files are parsed in parallel, then read in order
+  std::vector<std::future<File_IO_handle> > subfiles;
+  for (const auto& d : m_dispatcher)
+  {
+    const std::string& section = d.first;
+    if (input.has(section))
+      for (std::size_t i = 0; i < input[section].size(); ++ i)
+      {
+        std::string s = input[section][i].string();
+        if (s != "")
+          subfiles.emplace_back (workers().submit ([=]() { return parse_file ("data/" + section + "/" + s + ".yaml"); }));
+      }
+  }
+
   callback->value()();
 
+  std::size_t subfile_idx = 0;
   for (const auto& d : m_dispatcher)
   {
     const std::string& section = d.first;
@@ -369,10 +413,8 @@ void File_IO::read_room (const std::string& file_name)
           func (s["id"].string(), s);
         else
         {
-          Core::File_IO subfile ("data/" + section + "/" + s.string() + ".yaml");
-          bool okay = subfile.parse();
-          check(okay, "Can't open data/" + section + "/" + s.string() + ".yaml");
-          func (s.string(), subfile.root());
+          File_IO_handle subfile = wait_for (subfiles[subfile_idx ++], callback->value());
+          func (s.string(), subfile->root());
         }
         callback->value()();
       }
@@ -399,6 +441,11 @@ void File_IO::read_room (const std::string& file_name)
         callback->value();
       }
 
+  for (C::Ground_map_handle ground_map : wait_for (ground_maps_future, callback->value()))
+    set (ground_map);
+
+  Core::Graphic::finish_deferred_loading (callback->value());
+
   emit ("Game", "in_new_room");
   emit ("Game", "loading_done");
   emit ("Window", "rescaled");
@@ -47,6 +47,8 @@ namespace C = Component;
 
 Graphic::Graphic (Content& content)
   : Base (content)
+  , m_image_revision (std::size_t(-1))
+  , m_position_revision (std::size_t(-1))
 {
   set<C::Double>("CPU", "usage", 0);
 }
@@ -105,69 +107,53 @@ void Graphic::run()
 #endif
   m_core.begin();
 
+  update_draw_list();
+
   using Image_with_info = std::tuple<C::Image_handle, double, double, double, double, double>;
   static std::vector<Image_with_info> to_display;
 
   double limit_width = Config::world_width;
   double limit_height = Config::world_height;
+  bool hide_cursor = status()->is (LOCKED, CUTSCENE);
 
-  for (const auto& e : components("image"))
-    if (auto img = C::cast<C::Image>(e))
+  for (Draw_item& item : m_draw_list)
+  {
+    const C::Image_handle& img = item.image;
+    if (!img->on())
+      continue;
+    if (hide_cursor && img->entity() == "Cursor")
+      continue;
+
+    if (!item.position)
+      item.position = get<C::Position>(img->entity() , "position");
+    Point p = item.position->value();
+    double zoom = 1.;
+    if (!item.position->is_interface())
     {
-      if (!img->on())
-        continue;
-      if (status()->is (LOCKED, CUTSCENE) &&
-          img->entity() == "Cursor")
-        continue;
-
-      auto position = get<C::Position>(img->entity() , "position");
-      Point p = position->value();
-      double zoom = 1.;
-      if (!position->is_interface())
-      {
-        p = p - camera;
-        zoom = current_zoom;
-      }
-
-      int xmin = img->xmin();
-      int ymin = img->ymin();
-      int xmax = img->xmax();
-      int ymax = img->ymax();
-
-      Point screen_position = p - img->scale() * Vector(img->origin());
+      p = p - camera;
+      zoom = current_zoom;
+    }
 
-      double xmin_target = zoom * screen_position.x();
-      double ymin_target = zoom * screen_position.y();
-      double xmax_target = zoom * (screen_position.x() + img->scale() * (xmax - xmin));
-      double ymax_target = zoom * (screen_position.y() + img->scale() * (ymax - ymin));
+    int xmin = img->xmin();
+    int ymin = img->ymin();
+    int xmax = img->xmax();
+    int ymax = img->ymax();
 
-      // Skip out of boundaries images
-      if ((xmax_target < 0 || xmin_target > limit_width)
-          && (ymax_target < 0 || ymin_target > limit_height))
-          continue;
+    Point screen_position = p - img->scale() * Vector(img->origin());
 
-      to_display.emplace_back (img, xmin_target, ymin_target, xmax_target, ymax_target, zoom);
-    }
+    double xmin_target = zoom * screen_position.x();
+    double ymin_target = zoom * screen_position.y();
+    double xmax_target = zoom * (screen_position.x() + img->scale() * (xmax - xmin));
+    double ymax_target = zoom * (screen_position.y() + img->scale() * (ymax - ymin));
 
-  std::sort (to_display.begin(), to_display.end(),
-             [](const Image_with_info& a, const Image_with_info& b) -> bool
-             {
-               if (std::get<0>(a)->z() == std::get<0>(b)->z())
-               {
-                 const std::string& aid = std::get<0>(a)->entity();
-                 const std::string& bid = std::get<0>(b)->entity();
-                 std::string acid = std::get<0>(a)->character_entity();
-                 if (aid == acid) // Not a character, just compare IDs
-                   return aid < bid;
-                 std::string bcid = std::get<0>(b)->character_entity();
-                 if (bid == bcid || acid != bcid) // Not a character or != characters, just compare IDs
-                   return aid < bid;
+    // Skip images outside of the screen
+    if (xmax_target < 0 || xmin_target > limit_width
+        || ymax_target < 0 || ymin_target > limit_height)
+        continue;
 
-                 // Else, for same character, sort _mouth > _head > _body
-                 return bid > aid;
-               }
-               return (std::get<0>(a)->z() < std::get<0>(b)->z());
-             });
+    // Draw list is already sorted
+    to_display.emplace_back (img, xmin_target, ymin_target, xmax_target, ymax_target, zoom);
+  }
 
   for (auto& td : to_display)
   {
@@ -293,6 +279,76 @@ void Graphic::run()
   SOSAGE_TIMER_STOP(System_Graphic__run);
 }
 
+void Graphic::declare_access (Access& access)
+{
+  // Debug display reads all sorts of components, don't list them
+  if (value<C::Boolean>(GAME__DEBUG))
+    return;
+
+  access.read ({ "filename", "fullscreen", "locale", "name", "new_room",
+                 "position", "status", "zoom" });
+  access.write ({ "clear_managers", "debug", "image", "name_changed",
+                  "rescaled", "toggle_fullscreen" });
+}
+
+void Graphic::update_draw_list()
+{
+  std::size_t image_revision = revision("image");
+  std::size_t position_revision = revision("position");
+  bool rebuild = (image_revision != m_image_revision
+                  || position_revision != m_position_revision);
+  m_image_revision = image_revision;
+  m_position_revision = position_revision;
+
+  if (rebuild)
+  {
+    SOSAGE_TIMER_START(System_Graphic__rebuild_draw_list);
+    m_draw_list.clear();
+    for (const auto& e : components("image"))
+      if (auto img = C::cast<C::Image>(e))
+        m_draw_list.push_back ({ img, request<C::Position>(img->entity(), "position"),
+                                 img->z(), 0 });
+
+    // Order of images at the same depth only depends on entities, so
+    // it is computed once here and stored as an integer rank
+    std::sort (m_draw_list.begin(), m_draw_list.end(),
+               [](const Draw_item& a, const Draw_item& b) -> bool
+               {
+                 const std::string& aid = a.image->entity();
+                 const std::string& bid = b.image->entity();
+                 std::string acid = a.image->character_entity();
+                 if (aid == acid) // Not a character, just compare IDs
+                   return aid < bid;
+                 std::string bcid = b.image->character_entity();
+                 if (bid == bcid || acid != bcid) // Not a character or != characters, just compare IDs
+                   return aid < bid;
+
+                 // Else, for same character, sort _mouth > _head > _body
+                 return bid > aid;
+               });
+    for (std::size_t i = 0; i < m_draw_list.size(); ++ i)
+      m_draw_list[i].rank = i;
+    SOSAGE_TIMER_STOP(System_Graphic__rebuild_draw_list);
+  }
+
+  bool sorted = !rebuild;
+  for (Draw_item& item : m_draw_list)
+    if (item.z != item.image->z())
+    {
+      item.z = item.image->z();
+      sorted = false;
+    }
+
+  if (!sorted)
+    std::sort (m_draw_list.begin(), m_draw_list.end(),
+               [](const Draw_item& a, const Draw_item& b) -> bool
+               {
+                 if (a.z == b.z)
+                   return a.rank < b.rank;
+                 return a.z < b.z;
+               });
+}
+
 void Graphic::run_loading()
 {
   m_core.begin();
@@ -740,35 +740,26 @@ void Interface::update_notifications()
       group->add(star);
     }
 
-    auto left = C::make_handle<C::Image>(id + "_left_circle", "image",
-                                         (is_achievement
-                                          ? get<C::Image>("Yellow_left_circle", "image")
-                                          : get<C::Image>("White_left_circle", "image")));
-    auto right = C::make_handle<C::Image>(id + "_right_circle", "image",
-                                          (is_achievement
-                                           ? get<C::Image>("Yellow_right_circle", "image")
-                                           : get<C::Image>("White_right_circle", "image")));
-
-
     int width = label->width() * 0.5;
     if (is_achievement)
       width += star->width() * 0.25 + Config::label_margin;
 
-    auto back = C::make_handle<C::Image>(id + "_back", "image", 2 * width,
-                                         2 * Config::label_height,
-                                         255, (is_achievement ? 240 : 255),
-                                         (is_achievement ? 182 : 255));
-    left->compose_with (back);
-    back = left;
-    back->compose_with (right);
-
+    auto back = set<C::Image>(id + "_back", "image",
+                              (is_achievement
+                               ? get<C::Image>("Yellow_left_circle", "image")
+                               : get<C::Image>("White_left_circle", "image")),
+                              2 * width, 2 * Config::label_height,
+                              255, (is_achievement ? 240 : 255),
+                              (is_achievement ? 182 : 255),
+                              (is_achievement
+                               ? get<C::Image>("Yellow_right_circle", "image")
+                               : get<C::Image>("White_right_circle", "image")));
     back->set_relative_origin(0, 0);
     back->z() = depth;
     back->set_collision(UNCLICKABLE);
     back->set_alpha(alpha);
     back->set_scale(0.5 * Config::interface_scale);
     back->on() = true;
-    back = set<C::Image>(id + "_back", "image", back);
     group->add(back);
 
     if (back->width() * back->scale() > Config::world_width - 2 * Config::label_margin)
@@ -927,7 +918,12 @@ void Interface::update_inventory()
       int x = inventory_margin + int(relative_pos * inventory_width);
       int y = Config::inventory_height / 2;
 
-      set<C::Relative_position>(inventory->get(i) , "position", inventory_origin, Vector(x,y));
+      // Update position in place so that the draw list stays valid
+      auto item_position = request<C::Relative_position>(inventory->get(i) , "position");
+      if (item_position && item_position->absolute_reference() == inventory_origin)
+        item_position->set (Vector(x,y));
+      else
+        set<C::Relative_position>(inventory->get(i) , "position", inventory_origin, Vector(x,y));
     }
     else
       img->on() = false;
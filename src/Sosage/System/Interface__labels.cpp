@@ -154,7 +154,7 @@ void Interface::create_label (const std::string& id, std::string name,
 
   unsigned char alpha = (ltype == LABEL_BUTTON ? 255 : 100);
 
-  C::Image_handle label, left, right, back;
+  C::Image_handle label, left, right;
   if (name != "")
   {
     capitalize(name);
@@ -175,24 +175,18 @@ void Interface::create_label (const std::string& id, std::string name,
     label->set_alpha(scaled_alpha);
   }
 
+  // Caps are shared with the interface images, nothing is allocated
   if (ltype == GOTO_LEFT && mode != MOUSE)
-      left = C::make_handle<C::Image>(id + "_left_circle", "image", get<C::Image>("Goto_left", "image"));
-
+    left = get<C::Image>("Goto_left", "image");
   if (ltype != GOTO_LEFT && ltype != OPEN && ltype != CURSOR_LEFT)
-  {
-    left = C::make_handle<C::Image>(id + "_left_circle", "image", get<C::Image>("Left_circle", "image"));
-    left->set_alpha(alpha);
-  }
+    left = get<C::Image>("Left_circle", "image");
 
   if (ltype == GOTO_RIGHT && mode != MOUSE)
-      right = C::make_handle<C::Image>(id + "_right_circle", "image", get<C::Image>("Goto_right", "image"));
-
+    right = get<C::Image>("Goto_right", "image");
   if (ltype != GOTO_RIGHT && ltype != OPEN && ltype != CURSOR_RIGHT)
-  {
-    right = C::make_handle<C::Image>(id + "_right_circle", "image", get<C::Image>("Right_circle", "image"));
-    right->set_alpha(alpha);
-  }
+    right = get<C::Image>("Right_circle", "image");
 
+  int width = 0;
   if (label)
   {
     int margin = Config::label_margin;
@@ -208,7 +202,7 @@ void Interface::create_label (const std::string& id, std::string name,
     if (request<C::String>("Interface", "source_object"))
       margin = 3 * Config::label_margin;
 
-    int width = margin + label->width() / 2;
+    width = margin + label->width() / 2;
     if (ltype == LABEL_BUTTON || name.size() == 1)
       width = (name.size() - 1) * Config::label_margin;
     if (scale != 1.0)
@@ -218,38 +212,16 @@ void Interface::create_label (const std::string& id, std::string name,
       while (width % factor != 0)
         ++ width;
     }
-
-    if (width != 0)
-    {
-      back = C::make_handle<C::Image>(id + "_back", "image", 2* width, 2 * Config::label_height);
-
-      back->set_relative_origin(0.5, 0.5);
-      back->set_scale(scale);
-      back->set_alpha(alpha);
-      back->z() = depth - 1;
-      back->set_collision(collision);
-    }
-  }
-
-  if (left)
-  {
-    if (back)
-      left->compose_with (back);
-    back = left;
-  }
-  if (right)
-  {
-    back->compose_with (right);
   }
 
+  auto back = set<C::Image>(id + "_back", "image", left, 2 * width,
+                            (width != 0 ? 2 * Config::label_height : 0), 0, 0, 0, right);
   back->on() = true;
   back->set_relative_origin(0.5, 0.5);
   back->set_scale(0.5 * scale);
   back->set_alpha(alpha);
   back->z() = depth - 1;
   back->set_collision(collision);
-
-  back = set<C::Image>(id + "_back", "image", back);
   group->add(back);
 
   SOSAGE_TIMER_STOP(Interface__create_label);
@@ -173,4 +173,19 @@ void Sound::run()
   SOSAGE_TIMER_STOP(System_Sound__run);
 }
 
+void Sound::declare_access (Access& access)
+{
+  // Only touches music and sound components, so it can run on a
+  // worker thread (SDL mixer calls lock the audio device themselves),
+  // unless debug output goes to the shared (unsynchronized) buffer
+#ifndef SOSAGE_DEBUG_BUFFER
+  access.main_thread = false;
+#endif
+  access.read ({ "code", "name", "panning", "position", "save", "sound",
+                 "status", "time", "volume" });
+  access.write ({ "adjust_mix", "fade", "music", "play_click", "play_failure",
+                  "play_sound", "play_success", "resume_at", "start", "stop",
+                  "volume_changed" });
+}
+
 } // namespace Sosage::System
@@ -26,6 +26,7 @@
 
 
 #include <Sosage/Component/Debug.h>
+#include <Sosage/Core/Graphic.h>
 #include <Sosage/System/Time.h>
 #include <Sosage/Utils/profiling.h>
 
@@ -37,6 +38,16 @@ namespace C = Component;
 Time::Time (Content& content)
   : Base (content)
   , m_loading (false)
+  , m_pacing_started (false)
+  , m_refresh_rate (Config::default_refresh_rate)
+  , m_display (-1)
+  , m_vsync_effective (true)
+  , m_latest_frame (0)
+  , m_next_check (0)
+  , m_probe_frames (0)
+  , m_probe_time (0)
+  , m_present_frames (0)
+  , m_present_time (0)
 {
   set_fac<C::Debug>(GAME__DEBUG, "Game", "debug", m_content, m_clock);
   set_fac<C::Double> (CLOCK__TIME, "Clock", "time", 0.);
@@ -129,58 +140,95 @@ void Time::run()
 
 void Time::limit_fps()
 {
-  static bool needs_limits = false;
-  static bool game_started = false;
-  static bool needs_update = true;
-  static double latest_refresh = 0.;
-  static double refresh_time = 0.;
-  static int nb_refresh = 0;
-  if (needs_update)
+  double now = Core::Time::precise_now();
+
+  // Loading frames are irregular, only start once the game runs
+  if (!m_pacing_started)
   {
-    if (!game_started)
-    {
-      if (signal ("Game", "new_room_loaded"))
-      {
-        latest_refresh = m_clock.time();
-        refresh_time = 0;
-        nb_refresh = 0;
-        game_started = true;
-      }
+    if (!signal ("Game", "new_room_loaded"))
       return;
-    }
+    m_pacing_started = true;
+    m_latest_frame = now;
+    m_next_check = now;
+    m_display = Core::Graphic::display();
+    start_vsync_probe();
+    return;
+  }
 
-    if (m_clock.time() == 0)
-      return;
+  double interval = now - m_latest_frame;
 
-    refresh_time += (m_clock.time() - latest_refresh);
-    nb_refresh ++;
-    latest_refresh = m_clock.time();
+  // Refresh rate changes when the window moves to another display
+  if (now >= m_next_check)
+  {
+    int refresh_rate = Core::Graphic::refresh_rate();
+    if (refresh_rate <= 0)
+      refresh_rate = Config::default_refresh_rate;
+    int display = Core::Graphic::display();
+    if (refresh_rate != m_refresh_rate || display != m_display)
+    {
+      debug << "Display " << display << " at " << refresh_rate << "Hz" << std::endl;
+      m_refresh_rate = refresh_rate;
+      m_display = display;
+      start_vsync_probe();
+    }
+    m_next_check = now + 1.;
+  }
 
-    if (refresh_time > 5)
+  double period = 1. / m_refresh_rate;
+  if (m_probe_frames != 0)
+  {
+    // Without pacing, frames faster than the display mean that
+    // presenting does not wait for VSync
+    m_probe_time += interval;
+    if (-- m_probe_frames == 0)
     {
-      refresh_time /= nb_refresh;
-      double estimated_fps = 1. / refresh_time;
-      if (estimated_fps > 70)
-      {
-        debug << "FPS = " << estimated_fps << ", activating limit to 60 FPS" << std::endl;
-        needs_limits = true;
-      }
-      else
+      double mean = m_probe_time / Config::vsync_probe_frames;
+      bool vsync_effective = (mean > Config::vsync_tolerance * period);
+      if (vsync_effective != m_vsync_effective)
+        debug << "FPS = " << 1. / mean << ", " << (vsync_effective ? "deactivating" : "activating")
+              << " limit to " << m_refresh_rate << " FPS" << std::endl;
+      m_vsync_effective = vsync_effective;
+    }
+  }
+  else
+  {
+    // When VSync is effective, presenting waits for the display
+    m_present_time += Core::Graphic::present_time();
+    if (++ m_present_frames == Config::vsync_probe_frames)
+    {
+      double mean = m_present_time / m_present_frames;
+      bool vsync_effective = (mean > Config::vsync_present_ratio * period);
+      if (vsync_effective != m_vsync_effective)
+        debug << "Present blocks " << 1000. * mean << "ms, "
+              << (vsync_effective ? "deactivating" : "activating")
+              << " limit to " << m_refresh_rate << " FPS" << std::endl;
+      m_vsync_effective = vsync_effective;
+      m_present_frames = 0;
+      m_present_time = 0.;
+    }
+
+    if (!m_vsync_effective)
+    {
+      // Deadline is relative to the previous frame so that sleep errors
+      // don't accumulate
+      double deadline = m_latest_frame + period;
+      if (now < deadline)
       {
-        debug << "FPS = " << estimated_fps << ", no limit needed" << std::endl;
+        m_clock.precise_sleep (deadline - now);
+        now = Core::Time::precise_now();
       }
-      needs_update = false;
     }
   }
 
-  if (needs_limits)
-  {
-    constexpr double refresh_time = (1. / 60);
-    double time_spent = m_clock.time() - latest_refresh;
-    if (time_spent < refresh_time)
-      m_clock.sleep (refresh_time - time_spent);
-    latest_refresh = m_clock.time();
-  }
+  m_latest_frame = now;
+}
+
+void Time::start_vsync_probe()
+{
+  m_probe_frames = Config::vsync_probe_frames;
+  m_probe_time = 0.;
+  m_present_frames = 0;
+  m_present_time = 0.;
 }
 
 } // namespace Sosage::System
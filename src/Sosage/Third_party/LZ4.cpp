@@ -31,12 +31,14 @@
 #include <lz4.h>
 #include <lz4hc.h>
 
+#include <cstring>
+
 //#define SOSAGE_FAST_COMPRESS
 
 namespace Sosage
 {
 
-Buffer lz4_compress_buffer (void* data, std::size_t size)
+Buffer lz4_compress_buffer (const void* data, std::size_t size)
 {
   const char* cdata = reinterpret_cast<const char*>(data);
   unsigned int max_lz4_size = LZ4_compressBound(size);
@@ -51,9 +53,9 @@ Buffer lz4_compress_buffer (void* data, std::size_t size)
   return out;
 }
 
-void lz4_decompress_buffer (void* data, std::size_t size, void* out, std::size_t output_size)
+void lz4_decompress_buffer (const void* data, std::size_t size, void* out, std::size_t output_size)
 {
-  const char* cdata = reinterpret_cast<const char*>(data);
+  const char* cdata = static_cast<const char*>(data);
   char* cout = reinterpret_cast<char*>(out);
   int decompressed_size = LZ4_decompress_safe (cdata, cout, size, output_size);
 
@@ -62,4 +64,35 @@ void lz4_decompress_buffer (void* data, std::size_t size, void* out, std::size_t
          + to_string(decompressed_size) + " != " + to_string(output_size) + ")");
 }
 
+Buffer compress_buffer (const void* data, std::size_t size, Codec& codec)
+{
+  Buffer out = lz4_compress_buffer (data, size);
+#ifdef SOSAGE_FAST_COMPRESS
+  codec = CODEC_LZ4;
+#else
+  codec = CODEC_LZ4HC;
+#endif
+
+  // Already compressed data (OGG, etc.) is not worth decompressing
+  if (out.size() > size * (1. - Config::min_compression_gain))
+  {
+    const char* cdata = reinterpret_cast<const char*>(data);
+    out.assign (cdata, cdata + size);
+    codec = CODEC_STORED;
+  }
+  return out;
+}
+
+void decompress_buffer (Codec codec, const void* data, std::size_t size, void* out, std::size_t output_size)
+{
+  if (codec == CODEC_STORED)
+  {
+    check (size == output_size, "Stored size differs from expected ("
+           + to_string(size) + " != " + to_string(output_size) + ")");
+    std::memcpy (out, data, size);
+  }
+  else
+    lz4_decompress_buffer (data, size, out, output_size);
+}
+
 } // namespace Sosage
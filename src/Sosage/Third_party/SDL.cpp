@@ -32,10 +32,22 @@
 #include <Sosage/Utils/error.h>
 #include <Sosage/Utils/image_split.h>
 #include <Sosage/Utils/profiling.h>
+#include <Sosage/Utils/Worker_pool.h>
 
 #include <SDL_image.h>
 #include <SDL_hints.h>
 
+// Texts are drawn from a glyph atlas, see layout_text()
+#if !SDL_VERSION_ATLEAST(2,0,18)
+#error "SDL >= 2.0.18 is required (SDL_RenderGeometry)"
+#endif
+#ifndef SDL_TTF_VERSION_ATLEAST
+#error "SDL TTF >= 2.0.18 is required (glyph rendering and kerning)"
+#elif !SDL_TTF_VERSION_ATLEAST(2,0,18)
+#error "SDL TTF >= 2.0.18 is required (glyph rendering and kerning)"
+#endif
+
+#include <limits>
 #include <queue>
 #include <set>
 #include <sstream>
@@ -45,20 +57,31 @@ namespace Sosage::Third_party
 
 SDL_Window* SDL::m_window = nullptr;
 SDL_Renderer* SDL::m_renderer = nullptr;
+std::vector<SDL::Atlas_page> SDL::m_atlas_pages;
+std::vector<SDL::Atlas_page> SDL::m_glyph_pages;
+std::map<SDL::Glyph_key, SDL::Glyph> SDL::m_glyphs;
+std::vector<SDL_Vertex> SDL::m_glyph_vertices;
+std::vector<int> SDL::m_glyph_indices;
+double SDL::m_present_time = 0.;
 SDL::Image_manager SDL::m_images
 ([](Image_base* img)
 {
-  for (SDL_Texture* t : img->texture)
-    if (t != nullptr)
-      SDL_DestroyTexture (t);
+  if (img->atlas != -1)
+    release_from_atlas (img);
+  else
+    for (SDL_Texture* t : img->texture)
+      if (t != nullptr)
+        SDL_DestroyTexture (t);
   for (SDL_Texture* t : img->highlight)
     if (t != nullptr)
       SDL_DestroyTexture (t);
   delete img;
-});
+}, texture_memory, Config::texture_memory_budget);
 SDL::Font_manager SDL::m_fonts
 ([](Font_base* font)
 {
+  forget_glyphs (std::get<0>(*font));
+  forget_glyphs (std::get<1>(*font));
   TTF_CloseFont(std::get<0>(*font));
   TTF_CloseFont(std::get<1>(*font));
   delete std::get<2>(*font);
@@ -68,6 +91,10 @@ void* SDL::m_buffer = nullptr;
 void* SDL::m_hbuffer = nullptr;
 int SDL::m_max_texture_width = -1;
 int SDL::m_max_texture_height = -1;
+bool SDL::m_deferred_loading = false;
+bool SDL::m_pin_new_images = false;
+SDL_BlendMode SDL::m_highlight_blend_mode = SDL_BLENDMODE_INVALID;
+std::vector<SDL::Pending_image> SDL::m_pending_images;
 
 SDL::Image_base* SDL::make_images (const std::vector<SDL_Texture*>& texture,
                                    const std::vector<SDL_Texture*>& highlight,
@@ -78,6 +105,7 @@ SDL::Image_base* SDL::make_images (const std::vector<SDL_Texture*>& texture,
   out->highlight = highlight;
   out->width = width;
   out->height = height;
+  out->pinned = m_pin_new_images;
   return out;
 }
 
@@ -93,6 +121,25 @@ SDL::Image_base* SDL::make_image (SDL_Texture* texture,
   return out;
 }
 
+std::size_t SDL::texture_memory (const Image_base& image)
+{
+  std::size_t nb_layers = (image.with_highlight ? 2 : 1);
+  for (SDL_Texture* h : image.highlight)
+    if (h != nullptr)
+    {
+      nb_layers = 2;
+      break;
+    }
+  std::size_t area = 4 * std::size_t(image.width) * std::size_t(image.height);
+  if (image.atlas == -1)
+    return nb_layers * area;
+
+  // Images of a page share its whole memory, unused space included
+  const Atlas_page& page = m_atlas_pages[std::size_t(image.atlas)];
+  std::size_t page_memory = 4 * std::size_t(page.size) * std::size_t(page.size);
+  return page_memory / std::max (page.nb_images, std::size_t(1)) + (nb_layers - 1) * area;
+}
+
 SDL::Surface_access::Surface_access (SDL_Surface* surface)
   : surface (surface)
 {
@@ -273,7 +320,34 @@ SDL::Image SDL::load_image (const std::string& file_name, bool with_mask, bool w
 
   Image out;
 
-  if (Asset_manager::packaged())
+  if (Asset_manager::packaged() && m_deferred_loading)
+  {
+    // Only create an empty image here: tiles are decompressed by
+    // workers and uploaded by finish_deferred_loading()
+    int width, height, format_int;
+    std::tie (width, height, format_int) = Asset_manager::image_info (file_name);
+    bool created = false;
+    out = m_images.make_mapped
+      (file_name,
+       [&]() -> Image_base*
+       {
+         created = true;
+         std::size_t nb_tiles = Splitter::nb_sub (width) * Splitter::nb_sub (height);
+         Image_base* out = make_images (std::vector<SDL_Texture*>(nb_tiles, nullptr),
+                                        std::vector<SDL_Texture*>(nb_tiles, nullptr),
+                                        width, height);
+         out->with_highlight = with_highlight;
+         return out;
+       });
+    if (created)
+      m_pending_images.emplace_back
+        (out, workers().submit ([=]() -> Decoded_image
+                                {
+                                  return decode_image (file_name, width, height, format_int,
+                                                       with_mask);
+                                }));
+  }
+  else if (Asset_manager::packaged())
     out = m_images.make_mapped
       (file_name,
        [&]() -> Image_base*
@@ -282,18 +356,18 @@ SDL::Image SDL::load_image (const std::string& file_name, bool with_mask, bool w
          std::tie (width, height, format_int) = Asset_manager::image_info (file_name);
          Uint32 nb_x = Splitter::nb_sub (width);
          Uint32 nb_y = Splitter::nb_sub (height);
+         bool atlas = fits_in_atlas (file_name, width, height);
          Bitmap_2 mask;
-         std::vector<SDL_Texture*> textures;
-         std::vector<SDL_Texture*> highlights;
-         textures.reserve(nb_x * nb_y);
-         highlights.reserve(nb_x * nb_y);
+         Image_base* out = make_images (std::vector<SDL_Texture*>(nb_x * nb_y, nullptr),
+                                        std::vector<SDL_Texture*>(nb_x * nb_y, nullptr),
+                                        width, height);
+         out->with_highlight = with_highlight;
 
+         std::size_t idx = 0;
          for (Uint32 x = 0; x < nb_x; ++ x)
            for (Uint32 y = 0; y < nb_y; ++ y)
            {
              SDL_Surface* surf = nullptr;
-             SDL_Texture* highlight = nullptr;
-             SDL_Texture* texture = nullptr;
              SDL_Rect rect = Splitter::rect (width, height, x, y);
              SOSAGE_TIMER_START(SDL_Image__load_image_file);
              surf = SDL_CreateRGBSurfaceWithFormatFrom (m_buffer, rect.w, rect.h, 32, rect.w * 4, format_int);
@@ -304,30 +378,11 @@ SDL::Image SDL::load_image (const std::string& file_name, bool with_mask, bool w
 
 #ifndef SOSAGE_GUILESS
              SOSAGE_TIMER_START(SDL_Image__load_image_texture);
-             texture = SDL_CreateTextureFromSurface(m_renderer, surf);
-             check (texture != nullptr, "Cannot create texture from " + file_name
-             + " (" + std::string(SDL_GetError()) + ")");
+             create_tile_texture (out, idx, surf, atlas);
              SOSAGE_TIMER_STOP(SDL_Image__load_image_texture);
-
-             if (with_highlight)
-             {
-               SOSAGE_TIMER_START(SDL_Image__load_image_create_highlight);
-               SDL_Surface* high = nullptr;
-               high = SDL_CreateRGBSurfaceWithFormatFrom (m_hbuffer, rect.w, rect.h, 32, rect.w * 4, format_int);
-               SDL_LockSurface (high);
-               Asset_manager::open (file_name, high->pixels, x, y, true);
-               SDL_UnlockSurface (high);
-               SOSAGE_TIMER_STOP(SDL_Image__load_image_create_highlight);
-
-               SOSAGE_TIMER_START(SDL_Image__load_image_hightlight_2);
-               highlight = SDL_CreateTextureFromSurface(m_renderer, high);
-               SDL_FreeSurface (high);
-               SOSAGE_TIMER_STOP(SDL_Image__load_image_hightlight_2);
-             }
 #endif
-             textures.push_back(texture);
-             highlights.push_back(highlight);
              SDL_FreeSurface(surf);
+             ++ idx;
            }
 
          if (with_mask)
@@ -340,7 +395,6 @@ SDL::Image SDL::load_image (const std::string& file_name, bool with_mask, bool w
            SOSAGE_TIMER_STOP(SDL_Image__load_image_mask);
          }
 
-         auto out = make_images (textures, highlights, width, height);
          if (with_mask)
            out->mask = mask;
          return out;
@@ -350,8 +404,6 @@ SDL::Image SDL::load_image (const std::string& file_name, bool with_mask, bool w
       (file_name,
        [&]() -> Image_base*
        {
-         std::vector<SDL_Texture*> textures;
-         std::vector<SDL_Texture*> highlights;
          Bitmap_2 mask;
          SOSAGE_TIMER_START(SDL_Image__load_image_file);
          Asset asset = Asset_manager::open(file_name);
@@ -371,54 +423,22 @@ SDL::Image SDL::load_image (const std::string& file_name, bool with_mask, bool w
            nb_x = Splitter::nb_sub (width);
            nb_y = Splitter::nb_sub (height);
            debug << "Splitting overly large surface in " << nb_x << "x" << nb_y << std::endl;
-           textures.reserve(nb_x * nb_y);
-           highlights.reserve(nb_x * nb_y);
            surfaces = Splitter::split_image (surf);
          }
          else
            surfaces.push_back(surf);
 
+         Image_base* out = make_images (std::vector<SDL_Texture*>(surfaces.size(), nullptr),
+                                        std::vector<SDL_Texture*>(surfaces.size(), nullptr),
+                                        width, height);
+         out->with_highlight = with_highlight;
 
 #ifndef SOSAGE_GUILESS
          SOSAGE_TIMER_START(SDL_Image__load_image_texture);
+         bool atlas = (surfaces.size() == 1 && fits_in_atlas (file_name, width, height));
          for (std::size_t i = 0; i < surfaces.size(); ++ i)
-         {
-           SDL_Texture* texture
-             = SDL_CreateTextureFromSurface(m_renderer, surfaces[i]);
-           check (texture != nullptr, "Cannot create texture from " + file_name
-           + " (" + std::string(SDL_GetError()) + ")");
-           textures.push_back(texture);
-         }
+           create_tile_texture (out, i, surfaces[i], atlas);
          SOSAGE_TIMER_STOP(SDL_Image__load_image_texture);
-
-         if (with_highlight)
-         {
-           for (std::size_t i = 0; i < surfaces.size(); ++ i)
-           {
-             SOSAGE_TIMER_START(SDL_Image__load_image_create_highlight);
-             SDL_Surface* high = SDL_CreateRGBSurfaceWithFormat
-               (0, surfaces[i]->w, surfaces[i]->h, 32, SDL_PIXELFORMAT_ARGB8888);
-             SDL_FillRect(high, nullptr, SDL_MapRGBA
-               (high->format, Uint8(0), Uint8(0), Uint8(0), Uint8(0)));
-             SDL_BlitSurface (surfaces[i], nullptr, high, nullptr);
-
-             Surface_access access (high);
-             for (std::size_t j = 0; j < access.height(); ++ j)
-             for (std::size_t i = 0; i < access.width(); ++ i)
-             access.set(i,j, {255, 255, 255, (unsigned char)(0.5 * access.get(i,j)[3])});
-             access.release();
-             SOSAGE_TIMER_STOP(SDL_Image__load_image_create_highlight);
-
-             SOSAGE_TIMER_START(SDL_Image__load_image_hightlight_2);
-             SDL_Texture* highlight
-               = SDL_CreateTextureFromSurface(m_renderer, high);
-             SDL_FreeSurface (high);
-             SOSAGE_TIMER_STOP(SDL_Image__load_image_hightlight_2);
-             highlights.push_back(highlight);
-           }
-         }
-         else
-           highlights.push_back(nullptr);
 #endif
 
          if (with_mask)
@@ -430,7 +450,6 @@ SDL::Image SDL::load_image (const std::string& file_name, bool with_mask, bool w
          for (std::size_t i = 0; i < surfaces.size(); ++ i)
            SDL_FreeSurface(surfaces[i]);
 
-         auto out = make_images (textures, highlights, width, height);
          if (with_mask)
            out->mask = mask;
          return out;
@@ -441,70 +460,296 @@ SDL::Image SDL::load_image (const std::string& file_name, bool with_mask, bool w
   return out;
 }
 
-SDL::Image SDL::compose (const std::initializer_list<SDL::Image>& images)
+SDL::Decoded_image SDL::decode_image (const std::string& file_name, int width, int height,
+                                      int format, bool with_mask)
 {
-  // Compose images horitonzally
-  Uint32 total_height = 0;
-  Uint32 total_width = 0;
-  for (SDL::Image img : images)
+  Decoded_image out;
+  Uint32 nb_x = Splitter::nb_sub (width);
+  Uint32 nb_y = Splitter::nb_sub (height);
+  out.tiles.reserve (nb_x * nb_y);
+  out.atlas = fits_in_atlas (file_name, width, height);
+
+  // Worker threads can't share m_buffer, each tile gets its own surface
+  for (Uint32 x = 0; x < nb_x; ++ x)
+    for (Uint32 y = 0; y < nb_y; ++ y)
+    {
+      SDL_Rect rect = Splitter::rect (width, height, x, y);
+      SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormat (0, rect.w, rect.h, 32, format);
+      SDL_LockSurface (surf);
+      Asset_manager::open (file_name, surf->pixels, x, y);
+      SDL_UnlockSurface (surf);
+      out.tiles.push_back (surf);
+    }
+
+  if (with_mask)
   {
-    total_height = std::max(Uint32(height(img)), total_height);
-    total_width += width (img);
+    out.mask = Bitmap_2 (width, height, false);
+    Asset asset = Asset_manager::open (file_name + ".mask");
+    asset.read (out.mask.data(), out.mask.size());
+    asset.close();
   }
 
-#ifndef SOSAGE_GUILESS
-  SDL_Texture* texture = SDL_CreateTexture (m_renderer, SDL_PIXELFORMAT_ARGB8888,
-                                            SDL_TEXTUREACCESS_TARGET, total_width, total_height);
+  return out;
+}
 
-  SDL_SetRenderTarget(m_renderer, texture);
-  SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, 0);
-  SDL_RenderClear(m_renderer);
-  SDL_SetRenderDrawBlendMode(m_renderer, SDL_BLENDMODE_BLEND);
-  SDL_SetTextureBlendMode (texture, SDL_BLENDMODE_BLEND);
-  Uint32 x = 0;
-  for (SDL::Image img : images)
+void SDL::start_deferred_loading()
+{
+  m_deferred_loading = true;
+}
+
+void SDL::finish_deferred_loading (const std::function<void()>& callback)
+{
+  SOSAGE_TIMER_START(SDL_Image__finish_deferred_loading);
+  m_deferred_loading = false;
+
+  std::size_t nb_uploaded = 0;
+  for (Pending_image& pending : m_pending_images)
   {
-    SDL_Rect rect;
-    rect.h = height (img);
-    rect.w = width (img);
-    rect.x = x;
-    rect.y = (total_height - rect.h) / 2;
-    SDL_SetTextureBlendMode (img->texture[0], SDL_BLENDMODE_BLEND);
-    SDL_RenderCopy (m_renderer, img->texture[0], nullptr, &rect);
-    x += rect.w;
+    Decoded_image decoded = wait_for (pending.second, callback);
+    Image_base* image = pending.first.get();
+
+    for (std::size_t i = 0; i < decoded.tiles.size(); ++ i)
+    {
+      create_tile_texture (image, i, decoded.tiles[i], decoded.atlas);
+      SDL_FreeSurface (decoded.tiles[i]);
+    }
+
+    if (!decoded.mask.empty())
+      image->mask = decoded.mask;
+
+    // Upload textures by batches so that the loading screen keeps running
+    if (++ nb_uploaded % Config::texture_upload_batch == 0)
+      callback();
   }
+  m_pending_images.clear();
 
-  SDL_Texture* highlight = SDL_CreateTexture (m_renderer, SDL_PIXELFORMAT_ARGB8888,
-                                              SDL_TEXTUREACCESS_TARGET, total_width, total_height);
+  SOSAGE_TIMER_STOP(SDL_Image__finish_deferred_loading);
+}
 
-  SDL_SetRenderTarget(m_renderer, highlight);
-  SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, 0);
-  SDL_RenderClear(m_renderer);
-  SDL_SetRenderDrawBlendMode(m_renderer, SDL_BLENDMODE_BLEND);
-  SDL_SetTextureBlendMode (highlight, SDL_BLENDMODE_BLEND);
-  x = 0;
-  for (SDL::Image img : images)
+bool SDL::fits_in_atlas (const std::string& file_name, int width, int height)
+{
+  if (width > Config::atlas_max_image_size || height > Config::atlas_max_image_size)
+    return false;
+  for (const char* folder : Config::atlas_folders)
+    if (contains (file_name, folder))
+      return true;
+  return false;
+}
+
+void SDL::create_tile_texture (Image_base* image, std::size_t idx,
+                               SDL_Surface* tile, bool atlas)
+{
+#ifndef SOSAGE_GUILESS
+  if (atlas && pack_in_atlas (image, tile))
+    return;
+
+  image->texture[idx] = SDL_CreateTextureFromSurface (m_renderer, tile);
+  check (image->texture[idx] != nullptr, "Cannot create texture ("
+         + std::string(SDL_GetError()) + ")");
+#endif
+}
+
+bool SDL::pack_in_atlas (Image_base* image, SDL_Surface* tile)
+{
+  int page_size = std::min (Config::atlas_page_size,
+                            std::min (m_max_texture_width, m_max_texture_height));
+
+  std::size_t page_idx;
+  int x, y;
+  if (!allocate_in_atlas (m_atlas_pages, page_size, image->pinned,
+                          image->width + 2 * Config::atlas_padding,
+                          image->height + 2 * Config::atlas_padding,
+                          page_idx, x, y))
+    return false;
+
+  Atlas_page& page = m_atlas_pages[page_idx];
+  ++ page.nb_images;
+
+  upload_to_atlas (page, tile, x, y);
+  image->atlas = int(page_idx);
+  image->texture[0] = page.texture;
+  image->offset = { x + Config::atlas_padding, y + Config::atlas_padding };
+  return true;
+}
+
+bool SDL::allocate_in_atlas (std::vector<Atlas_page>& pages, int page_size,
+                             bool pinned, int slot_width, int slot_height,
+                             std::size_t& page_idx, int& x, int& y)
+{
+  if (slot_width > page_size || slot_height > page_size)
+    return false;
+
+  for (page_idx = 0; page_idx < pages.size(); ++ page_idx)
   {
-    SDL_Rect rect;
-    rect.h = height (img);
-    rect.w = width (img);
-    rect.x = x;
-    rect.y = (total_height - rect.h) / 2;
-    if (img->highlight[0])
+    Atlas_page& page = pages[page_idx];
+    if (page.texture == nullptr || page.pinned != pinned)
+      continue;
+
+    // Smallest freed slot that fits first, what remains of it on the
+    // right and below becomes two smaller free slots
+    std::size_t best = page.free_slots.size();
+    for (std::size_t i = 0; i < page.free_slots.size(); ++ i)
     {
-      SDL_SetTextureBlendMode (img->highlight[0], SDL_BLENDMODE_BLEND);
-      SDL_RenderCopy (m_renderer, img->highlight[0], nullptr, &rect);
+      const SDL_Rect& s = page.free_slots[i];
+      if (s.w >= slot_width && s.h >= slot_height
+          && (best == page.free_slots.size()
+              || s.w * s.h < page.free_slots[best].w * page.free_slots[best].h))
+        best = i;
     }
-    x += rect.w;
+    if (best != page.free_slots.size())
+    {
+      SDL_Rect slot = page.free_slots[best];
+      page.free_slots.erase (page.free_slots.begin() + std::ptrdiff_t(best));
+      if (slot.w > slot_width)
+        page.free_slots.push_back ({ slot.x + slot_width, slot.y, slot.w - slot_width, slot_height });
+      if (slot.h > slot_height)
+        page.free_slots.push_back ({ slot.x, slot.y + slot_height, slot.w, slot.h - slot_height });
+      x = slot.x;
+      y = slot.y;
+      return true;
+    }
+
+    // Else shelf packing: images are put side by side on the last
+    // shelf of a page, and a new shelf is opened below when it is full
+    x = page.cursor_x;
+    y = page.shelf_y;
+    int shelf_height = page.shelf_height;
+    if (x + slot_width > page_size)
+    {
+      x = 0;
+      y += shelf_height;
+      shelf_height = 0;
+    }
+    if (y + slot_height > page_size)
+      continue;
+
+    page.cursor_x = x + slot_width;
+    page.shelf_y = y;
+    page.shelf_height = std::max (shelf_height, slot_height);
+    return true;
   }
 
-  SDL_SetRenderTarget(m_renderer, nullptr);
-#else
-  SDL_Texture* texture = nullptr;
-  SDL_Texture* highlight = nullptr;
-#endif
+  SDL_Texture* texture = SDL_CreateTexture (m_renderer, SDL_PIXELFORMAT_ARGB8888,
+                                            SDL_TEXTUREACCESS_STATIC, page_size, page_size);
+  if (texture == nullptr)
+    return false;
+  SDL_SetTextureBlendMode (texture, SDL_BLENDMODE_BLEND);
+
+  // Entries of destroyed pages are reused, images keep indices of theirs
+  for (page_idx = 0; page_idx < pages.size(); ++ page_idx)
+    if (pages[page_idx].texture == nullptr)
+      break;
+  if (page_idx == pages.size())
+    pages.emplace_back();
+  debug << "Creating atlas page " << page_idx << (pinned ? " (pinned)" : "") << std::endl;
+
+  Atlas_page& page = pages[page_idx];
+  page = Atlas_page();
+  page.texture = texture;
+  page.cursor_x = slot_width;
+  page.shelf_height = slot_height;
+  page.size = page_size;
+  page.pinned = pinned;
+  x = 0;
+  y = 0;
+  return true;
+}
+
+void SDL::upload_to_atlas (const Atlas_page& page, SDL_Surface* surface, int x, int y)
+{
+  // Surround with transparent pixels so that neighbours don't bleed
+  // on each other when the page is sampled with linear filtering
+  SDL_Surface* padded = SDL_CreateRGBSurfaceWithFormat
+    (0, surface->w + 2 * Config::atlas_padding, surface->h + 2 * Config::atlas_padding,
+     32, SDL_PIXELFORMAT_ARGB8888);
+  SDL_FillRect (padded, nullptr, SDL_MapRGBA (padded->format, 0, 0, 0, 0));
+
+  SDL_Rect target { Config::atlas_padding, Config::atlas_padding, surface->w, surface->h };
+  SDL_SetSurfaceBlendMode (surface, SDL_BLENDMODE_NONE);
+  SDL_BlitSurface (surface, nullptr, padded, &target);
+
+  SDL_Rect area { x, y, padded->w, padded->h };
+  SDL_UpdateTexture (page.texture, &area, padded->pixels, padded->pitch);
+  SDL_FreeSurface (padded);
+}
+
+void SDL::release_from_atlas (Image_base* image)
+{
+  Atlas_page& page = m_atlas_pages[std::size_t(image->atlas)];
+  if (-- page.nb_images == 0)
+  {
+    debug << "Destroying atlas page " << image->atlas << std::endl;
+    SDL_DestroyTexture (page.texture);
+    page = Atlas_page();
+    return;
+  }
 
-  return m_images.make_single (make_image, texture, highlight, total_width, total_height);
+  page.free_slots.push_back ({ image->offset.x - Config::atlas_padding,
+                               image->offset.y - Config::atlas_padding,
+                               image->width + 2 * Config::atlas_padding,
+                               image->height + 2 * Config::atlas_padding });
+}
+
+SDL_Texture* SDL::highlight (Image_base* image, std::size_t idx, int width, int height)
+{
+  if (image->highlight[idx] != nullptr || !image->with_highlight)
+    return image->highlight[idx];
+
+  // Highlight is white with half the alpha of the texture: render the
+  // texture onto a white transparent target, keeping the color of the
+  // target and taking the alpha of the source
+  SDL_Texture* texture = image->texture[idx];
+  SDL_Texture* out = SDL_CreateTexture (m_renderer, SDL_PIXELFORMAT_ARGB8888,
+                                        SDL_TEXTUREACCESS_TARGET, width, height);
+  if (out == nullptr || SDL_SetTextureBlendMode (texture, m_highlight_blend_mode) != 0)
+  {
+    debug << "Warning: cannot generate highlight (" << SDL_GetError() << ")" << std::endl;
+    if (out != nullptr)
+      SDL_DestroyTexture (out);
+    image->with_highlight = false;
+    return nullptr;
+  }
+
+  SDL_Texture* current_target = SDL_GetRenderTarget (m_renderer);
+  SDL_SetRenderTarget (m_renderer, out);
+  SDL_SetRenderDrawColor (m_renderer, 255, 255, 255, 0);
+  SDL_RenderClear (m_renderer);
+
+  SDL_Rect source { image->offset.x, image->offset.y, width, height };
+  SDL_SetTextureAlphaMod (texture, 128);
+  SDL_RenderCopy (m_renderer, texture, &source, nullptr);
+  SDL_SetTextureBlendMode (texture, SDL_BLENDMODE_BLEND);
+  SDL_SetRenderTarget (m_renderer, current_target);
+
+  SDL_SetTextureBlendMode (out, SDL_BLENDMODE_BLEND);
+  image->highlight[idx] = out;
+  return out;
+}
+
+SDL::Image SDL::create_slices (const SDL::Image& left, int width, int height,
+                               int r, int g, int b, const SDL::Image& right)
+{
+  // Parts are put side by side and centered vertically
+  int left_width = (left ? left->width : 0);
+  int right_width = (right ? right->width : 0);
+  int total_height = std::max (height, std::max (left ? left->height : 0,
+                                                 right ? right->height : 0));
+
+  Image out = m_images.make_single (make_images, std::vector<SDL_Texture*>(),
+                                    std::vector<SDL_Texture*>(),
+                                    left_width + width + right_width, total_height);
+  out->sliced = true;
+  out->left = left;
+  out->right = right;
+  if (left)
+    out->left_area = { 0, (total_height - left->height) / 2, left->width, left->height };
+  out->middle_area = { left_width, (total_height - height) / 2, width, height };
+  if (right)
+    out->right_area = { left_width + width, (total_height - right->height) / 2,
+                        right->width, right->height };
+  out->middle_color = { Uint8(r), Uint8(g), Uint8(b), 255 };
+  out->with_highlight = ((left && left->with_highlight) || (right && right->with_highlight));
+  return out;
 }
 
 SDL::Font SDL::load_font (const std::string& file_name, int size)
@@ -520,6 +765,9 @@ SDL::Font SDL::load_font (const std::string& file_name, int size)
        TTF_Font* outlined = TTF_OpenFontRW(asset.base(), 1, size);
        check (outlined != nullptr, "Cannot load outlined font " + file_name);
        TTF_SetFontOutline (outlined, Config::text_outline);
+       // Stored fonts are read in place from the package and have no
+       // buffer (nullptr): this is fine as package memory stays
+       // mapped until Asset_manager::shutdown(), after fonts are freed
        return new Font_base (font, outlined, asset.buffer());
      });
   return out;
@@ -622,85 +870,205 @@ SDL_Color SDL::color (const std::string& color_str)
 SDL::Image SDL::create_text (const SDL::Font& font, const std::string& color_str,
                              const std::string& text)
 {
-  // Debug info constantly changes, so saving each version leads to a
-  // memory explosion. This fix is a bit hacky...
-  if (contains(text, "[Debug info]"))
-  {
-    SDL_Surface* surf;
-    surf = TTF_RenderUTF8_Blended_Wrapped(std::get<0>(*font), text.c_str(), color(color_str), 1920);
-    int width = surf->w;
-    int height = surf->h;
-    check (surf != nullptr, "Cannot create text \"" + text + "\"");
-#ifndef SOSAGE_GUILESS
-    SDL_Texture* out = SDL_CreateTextureFromSurface (m_renderer, surf);
-    check (out != nullptr, "Cannot create texture from text \"" + text + "\"");
-#else
-    SDL_Texture* out = nullptr;
-#endif
-    SDL_FreeSurface (surf);
-    return m_images.make_single(make_image, out, nullptr, width, height);
-  }
+  return layout_text (font, color(color_str), text, false);
+}
 
-  std::string id = to_string(std::size_t(std::get<0>(*font))) + color_str + text;
-  return m_images.make_mapped
-      (id, [&]() -> Image_base*
+SDL::Image SDL::create_outlined_text (const SDL::Font& font, const std::string& color_str,
+                                      const std::string& text)
+{
+  return layout_text (font, color(color_str), text, true);
+}
+
+SDL::Image SDL::layout_text (const SDL::Font& font, const SDL_Color& color,
+                             const std::string& text, bool outlined)
+{
+  TTF_Font* front = std::get<0>(*font);
+  TTF_Font* back = std::get<1>(*font);
+  int outline = (outlined ? Config::text_outline : 0);
+  int line_skip = TTF_FontLineSkip (front);
+
+  // Like TTF_RenderUTF8_Blended_Wrapped, only multiline texts are wrapped
+  int wrap_width = (contains (text, "\n") ? Config::text_wrap_width
+                                          : std::numeric_limits<int>::max());
+
+  std::vector<unsigned int> codepoints = utf8_codepoints (text);
+
+  Image out = m_images.make_single (make_images, std::vector<SDL_Texture*>(),
+                                    std::vector<SDL_Texture*>(), 0, 0);
+  out->text = true;
+
+  // Outline quads are all drawn first so that they never cover the
+  // text of the previous glyph
+  std::vector<Glyph_quad> front_quads;
+  front_quads.reserve (codepoints.size());
+  out->glyphs.reserve (outlined ? 2 * codepoints.size() : codepoints.size());
+
+  int width = 0;
+  int x = 0;
+  int y = 0;
+  Uint32 previous = 0;
+  for (std::size_t i = 0; i < codepoints.size(); ++ i)
   {
-    SDL_Surface* surf = nullptr;
-    if (!contains (text, "\n"))
-      surf = TTF_RenderUTF8_Blended(std::get<0>(*font), text.c_str(), color(color_str));
-    else
-      surf = TTF_RenderUTF8_Blended_Wrapped(std::get<0>(*font), text.c_str(), color(color_str), 1920);
-    check (surf != nullptr, "Cannot create text \"" + text + "\"");
+    Uint32 c = codepoints[i];
+    if (c == '\n')
+    {
+      x = 0;
+      y += line_skip;
+      previous = 0;
+      continue;
+    }
 
-    int width = surf->w;
-    int height = surf->h;
+    // Words that would overflow start a new line
+    if (c != ' ' && x != 0 && codepoints[i-1] == ' ')
+    {
+      int word_width = 0;
+      for (std::size_t j = i; j < codepoints.size() && codepoints[j] != ' '
+             && codepoints[j] != '\n'; ++ j)
+        word_width += glyph (front, codepoints[j]).advance;
+      if (x + word_width > wrap_width)
+      {
+        x = 0;
+        y += line_skip;
+        previous = 0;
+      }
+    }
 
-#ifndef SOSAGE_GUILESS
-    SDL_Texture* out = SDL_CreateTextureFromSurface(m_renderer, surf);
-    check (out != nullptr, "Cannot create texture from text \"" + text + "\"");
-#else
-    SDL_Texture* out = nullptr;
-#endif
-    SDL_FreeSurface (surf);
-    return make_image (out, nullptr, width, height);
-  });
+    if (previous != 0)
+      x += TTF_GetFontKerningSizeGlyphs32 (front, previous, c);
+    previous = c;
+
+    const Glyph& g = glyph (front, c);
+    if (outlined)
+    {
+      const Glyph& o = glyph (back, c);
+      out->glyphs.push_back ({ o.page, o.source, x + o.offset, y, black() });
+      width = std::max (width, x + o.offset + o.source.w);
+    }
+    front_quads.push_back ({ g.page, g.source, x + g.offset + outline, y + outline, color });
+    width = std::max (width, x + g.offset + outline + g.source.w);
+
+    x += g.advance;
+    width = std::max (width, x + 2 * outline);
+  }
+
+  out->glyphs.insert (out->glyphs.end(), front_quads.begin(), front_quads.end());
+  out->width = width;
+  out->height = y + TTF_FontHeight (front) + 2 * outline;
+  return out;
 }
 
-SDL::Image SDL::create_outlined_text (const SDL::Font& font, const std::string& color_str,
-                                      const std::string& text)
+const SDL::Glyph& SDL::glyph (TTF_Font* font, Uint32 codepoint)
 {
-  std::string id = to_string(std::size_t(std::get<0>(*font))) + "outlined" + color_str + text;
+  auto inserted = m_glyphs.insert (std::make_pair (Glyph_key (font, codepoint), Glyph()));
+  Glyph& out = inserted.first->second;
+  if (!inserted.second)
+    return out;
 
-  return m_images.make_mapped
-    (id,
-     [&]() -> Image_base*
-     {
-       SDL_Surface* surf = TTF_RenderUTF8_Blended (std::get<0>(*font), text.c_str(), color(color_str));
-       check (surf != nullptr, "Cannot create text \"" + text + "\"");
+  int minx, maxx, miny, maxy, advance;
+  if (TTF_GlyphMetrics32 (font, codepoint, &minx, &maxx, &miny, &maxy, &advance) == 0)
+  {
+    out.offset = std::min (0, minx);
+    out.advance = advance;
+  }
 
-       SDL_Surface* back = TTF_RenderUTF8_Blended (std::get<1>(*font), text.c_str(), black());
-       check (back != nullptr, "Cannot create text \"" + text + "\"");
+#ifndef SOSAGE_GUILESS
+  SDL_Color white { 255, 255, 255, 255 };
+  SDL_Surface* surf = TTF_RenderGlyph32_Blended (font, codepoint, white);
+  if (surf == nullptr) // Nothing to draw (spaces, missing glyphs)
+    return out;
+
+  int page_size = std::min (Config::glyph_page_size,
+                            std::min (m_max_texture_width, m_max_texture_height));
+  int x, y;
+  if (allocate_in_atlas (m_glyph_pages, page_size, false,
+                         surf->w + 2 * Config::atlas_padding,
+                         surf->h + 2 * Config::atlas_padding,
+                         out.page, x, y))
+  {
+    upload_to_atlas (m_glyph_pages[out.page], surf, x, y);
+    out.source = { x + Config::atlas_padding, y + Config::atlas_padding, surf->w, surf->h };
+  }
+  else
+    debug << "Warning: cannot store glyph " << codepoint << " in atlas" << std::endl;
+  SDL_FreeSurface (surf);
+#endif
 
-       SDL_Rect rect = {Config::text_outline, Config::text_outline, surf->w, surf->h};
-       SDL_SetSurfaceBlendMode(surf, SDL_BLENDMODE_BLEND);
-       SDL_BlitSurface (surf, NULL, back, &rect);
+  return out;
+}
 
-       int width = back->w;
-       int height = back->h;
+void SDL::forget_glyphs (TTF_Font* font)
+{
+  // Glyph slots are not reclaimed, but a new font allocated at the
+  // same address must not find the glyphs of the old one
+  for (auto it = m_glyphs.lower_bound (Glyph_key (font, 0));
+       it != m_glyphs.end() && it->first.first == font; )
+    it = m_glyphs.erase (it);
+}
 
+void SDL::draw_glyphs (const Image_base* image, unsigned char alpha,
+                       const SDL_Rect& source, const SDL_FRect& target)
+{
 #ifndef SOSAGE_GUILESS
-       SDL_Texture* out = SDL_CreateTextureFromSurface(m_renderer, back);
-       check (out != nullptr, "Cannot create texture from text \"" + text + "\"");
-#else
-       SDL_Texture* out = nullptr;
+  float xscale = target.w / source.w;
+  float yscale = target.h / source.h;
+
+  std::size_t page = 0;
+  auto flush = [&]()
+  {
+    if (m_glyph_indices.empty())
+      return;
+    SDL_RenderGeometry (m_renderer, m_glyph_pages[page].texture,
+                        m_glyph_vertices.data(), int(m_glyph_vertices.size()),
+                        m_glyph_indices.data(), int(m_glyph_indices.size()));
+    m_glyph_vertices.clear();
+    m_glyph_indices.clear();
+  };
+
+  for (const Glyph_quad& q : image->glyphs)
+  {
+    if (q.source.w == 0)
+      continue;
+
+    // Crop to the source area, texture coordinates follow
+    int xmin = std::max (q.x, source.x);
+    int xmax = std::min (q.x + q.source.w, source.x + source.w);
+    int ymin = std::max (q.y, source.y);
+    int ymax = std::min (q.y + q.source.h, source.y + source.h);
+    if (xmin >= xmax || ymin >= ymax)
+      continue;
+
+    if (q.page != page)
+    {
+      flush();
+      page = q.page;
+    }
+
+    float size = float(m_glyph_pages[page].size);
+    float u0 = (q.source.x + xmin - q.x) / size;
+    float u1 = (q.source.x + xmax - q.x) / size;
+    float v0 = (q.source.y + ymin - q.y) / size;
+    float v1 = (q.source.y + ymax - q.y) / size;
+
+    float x0 = target.x + (xmin - source.x) * xscale;
+    float x1 = target.x + (xmax - source.x) * xscale;
+    float y0 = target.y + (ymin - source.y) * yscale;
+    float y1 = target.y + (ymax - source.y) * yscale;
+
+    SDL_Color color = q.color;
+    color.a = Uint8((int(color.a) * int(alpha)) / 255);
+
+    int first = int(m_glyph_vertices.size());
+    m_glyph_vertices.push_back ({ { x0, y0 }, color, { u0, v0 } });
+    m_glyph_vertices.push_back ({ { x1, y0 }, color, { u1, v0 } });
+    m_glyph_vertices.push_back ({ { x1, y1 }, color, { u1, v1 } });
+    m_glyph_vertices.push_back ({ { x0, y1 }, color, { u0, v1 } });
+    for (int idx : { 0, 1, 2, 0, 2, 3 })
+      m_glyph_indices.push_back (first + idx);
+  }
+  flush();
 #endif
-       SDL_FreeSurface (surf);
-       SDL_FreeSurface (back);
-       return make_image (out, nullptr, width, height);
-     });
 }
 
-
 int SDL::width (SDL::Image image)
 {
   return image->width;
@@ -733,40 +1101,22 @@ SDL::Surface SDL::load_surface (const std::string& file_name)
   return surf;
 }
 
-std::array<unsigned char, 3> SDL::get_color (SDL::Surface image, int x, int y)
+std::vector<unsigned char> SDL::get_colors (SDL::Surface image)
 {
-  SDL_LockSurface (image.get());
-
-  int bpp = image->format->BytesPerPixel;
-  Uint8 *p = (Uint8 *)image->pixels + y * image->pitch + x * bpp;
-  Uint32 data;
-  switch (bpp)
-  {
-    case 1:
-      data = *p;
-      break;
+  // Convert whole surface at once instead of decoding pixel per pixel
+  SDL_Surface* rgb = SDL_ConvertSurfaceFormat (image.get(), SDL_PIXELFORMAT_RGB24, 0);
+  check (rgb != nullptr, "Cannot convert surface (" + std::string(SDL_GetError()) + ")");
 
-    case 2:
-      data = *(Uint16 *)p;
-      break;
-
-    case 3:
-      if (SDL_BYTEORDER == SDL_BIG_ENDIAN)
-        data = Uint32(p[0] << 16 | p[1] << 8 | p[2]);
-      else
-        data = Uint32(p[0] | p[1] << 8 | p[2] << 16);
-      break;
+  std::size_t row_size = std::size_t(rgb->w) * 3;
+  std::vector<unsigned char> out (row_size * std::size_t(rgb->h));
 
-    case 4:
-      data = *(Uint32 *)p;
-      break;
+  SDL_LockSurface (rgb);
+  for (int y = 0; y < rgb->h; ++ y)
+    std::copy_n ((const unsigned char*)(rgb->pixels) + y * rgb->pitch, row_size,
+                 out.begin() + std::ptrdiff_t(y * row_size));
+  SDL_UnlockSurface (rgb);
+  SDL_FreeSurface (rgb);
 
-    default:
-      exit(0);
-  }
-  std::array<unsigned char, 3> out;
-  SDL_GetRGB(data, image->format, &out[0], &out[1], &out[2]);
-  SDL_UnlockSurface (image.get());
   return out;
 }
 
@@ -815,9 +1165,7 @@ void SDL::init (int& window_width, int& window_height, bool fullscreen)
   m_renderer = SDL_CreateRenderer (m_window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
   check (m_renderer != nullptr, "Cannot create SDL Renderer: (" + std::string(SDL_GetError()) + ")");
 
-  SDL_DisplayMode mode;
-  SDL_GetWindowDisplayMode(m_window, &mode);
-  debug << "Refresh rate: " << mode.refresh_rate << "Hz" << std::endl;
+  debug << "Refresh rate: " << refresh_rate() << "Hz" << std::endl;
 
   SDL_RendererInfo info;
   int result = SDL_GetRendererInfo (m_renderer, &info);
@@ -825,6 +1173,11 @@ void SDL::init (int& window_width, int& window_height, bool fullscreen)
   m_max_texture_width = info.max_texture_width;
   m_max_texture_height = info.max_texture_height;
 
+  // Color from destination, alpha from source (used to generate highlights)
+  m_highlight_blend_mode = SDL_ComposeCustomBlendMode
+    (SDL_BLENDFACTOR_ZERO, SDL_BLENDFACTOR_ONE, SDL_BLENDOPERATION_ADD,
+     SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ZERO, SDL_BLENDOPERATION_ADD);
+
   debug << "Video display: " << SDL_GetCurrentVideoDriver() << std::endl;
   debug << "Available video displays: " << std::endl;
   for (int i = 0; i < SDL_GetNumVideoDrivers(); ++ i)
@@ -861,10 +1214,16 @@ SDL::~SDL ()
 {
   delete[] (char*)m_buffer;
   delete[] (char*)m_hbuffer;
-  clear_managers();
+  m_images.clear();
+  m_fonts.clear();
   TTF_Quit ();
   IMG_Quit ();
 #ifndef SOSAGE_GUILESS
+  for (Atlas_page& page : m_atlas_pages)
+    if (page.texture != nullptr)
+      SDL_DestroyTexture (page.texture);
+  for (Atlas_page& page : m_glyph_pages)
+    SDL_DestroyTexture (page.texture);
   SDL_DestroyRenderer (m_renderer);
   SDL_DestroyWindow (m_window);
 #endif
@@ -873,8 +1232,17 @@ SDL::~SDL ()
 
 void SDL::clear_managers()
 {
-  m_images.clear();
-  m_fonts.clear();
+  m_images.shrink();
+  m_fonts.shrink();
+  debug << "Texture cache: " << m_images.size() << " images using "
+        << m_images.memory() / (1024 * 1024) << "MB" << std::endl;
+}
+
+void SDL::pin_new_resources (bool pin)
+{
+  m_pin_new_images = pin;
+  m_images.pin_new_resources (pin);
+  m_fonts.pin_new_resources (pin);
 }
 
 void SDL::update_window (const std::string& name, const std::string& icon_filename)
@@ -906,6 +1274,32 @@ void SDL::toggle_fullscreen (bool fullscreen)
 
 }
 
+int SDL::refresh_rate()
+{
+#ifndef SOSAGE_GUILESS
+  // Display of the window may change when it is moved
+  SDL_DisplayMode mode;
+  if (m_window != nullptr
+      && SDL_GetCurrentDisplayMode (SDL_GetWindowDisplayIndex (m_window), &mode) == 0)
+    return mode.refresh_rate;
+#endif
+  return 0;
+}
+
+int SDL::display()
+{
+#ifndef SOSAGE_GUILESS
+  if (m_window != nullptr)
+    return SDL_GetWindowDisplayIndex (m_window);
+#endif
+  return -1;
+}
+
+double SDL::present_time()
+{
+  return m_present_time;
+}
+
 void SDL::toggle_cursor (bool visible)
 {
   SDL_ShowCursor(visible ? SDL_ENABLE : SDL_DISABLE);
@@ -930,6 +1324,52 @@ void SDL::begin()
 #endif
 }
 
+void SDL::draw_slices (const Image_base* image, unsigned char alpha,
+                        unsigned char highlight_alpha,
+                        const SDL_Rect& source, const SDL_FRect& target)
+{
+#ifndef SOSAGE_GUILESS
+  float xscale = target.w / source.w;
+  float yscale = target.h / source.h;
+
+  // Each part is cropped to the source area and drawn where it lies
+  auto part_target = [&](const SDL_Rect& inter) -> SDL_FRect
+  {
+    return { target.x + (inter.x - source.x) * xscale,
+             target.y + (inter.y - source.y) * yscale,
+             inter.w * xscale, inter.h * yscale };
+  };
+
+  for (const auto& part : { std::make_pair (image->left, image->left_area),
+                            std::make_pair (image->right, image->right_area) })
+  {
+    SDL_Rect inter;
+    if (!part.first || SDL_IntersectRect (&source, &part.second, &inter) == SDL_FALSE)
+      continue;
+    SDL_FRect t = part_target (inter);
+    draw (part.first, alpha, highlight_alpha,
+          inter.x - part.second.x, inter.y - part.second.y, inter.w, inter.h,
+          t.x, t.y, t.w, t.h);
+  }
+
+  SDL_Rect inter;
+  if (SDL_IntersectRect (&source, &image->middle_area, &inter) == SDL_FALSE)
+    return;
+  SDL_FRect t = part_target (inter);
+  const SDL_Color& color = image->middle_color;
+  SDL_SetRenderDrawBlendMode (m_renderer, SDL_BLENDMODE_BLEND);
+  SDL_SetRenderDrawColor (m_renderer, color.r, color.g, color.b, alpha);
+  SDL_RenderFillRectF (m_renderer, &t);
+
+  // Same as generated highlights: white with half the alpha
+  if (highlight_alpha != 0 && image->with_highlight)
+  {
+    SDL_SetRenderDrawColor (m_renderer, 255, 255, 255, Uint8(highlight_alpha / 2));
+    SDL_RenderFillRectF (m_renderer, &t);
+  }
+#endif
+}
+
 void SDL::draw (const Image& image, unsigned char alpha,
                 unsigned char highlight_alpha,
                 const int xsource, const int ysource,
@@ -938,11 +1378,26 @@ void SDL::draw (const Image& image, unsigned char alpha,
                 const double wtarget, const double htarget)
 {
 #ifndef SOSAGE_GUILESS
-  if (image->texture.size() == 1)
+  if (image->sliced)
+  {
+    SDL_Rect source { xsource, ysource, wsource, hsource };
+    SDL_FRect target { float(xtarget), float(ytarget), float(wtarget), float(htarget) };
+    draw_slices (image.get(), alpha, highlight_alpha, source, target);
+  }
+  else if (image->text)
+  {
+    // Empty texts have no glyph (and no texture) to draw
+    if (image->glyphs.empty())
+      return;
+    SDL_Rect source { xsource, ysource, wsource, hsource };
+    SDL_FRect target { float(xtarget), float(ytarget), float(wtarget), float(htarget) };
+    draw_glyphs (image.get(), alpha, source, target);
+  }
+  else if (image->texture.size() == 1)
   {
     SDL_Rect source;
-    source.x = xsource;
-    source.y = ysource;
+    source.x = xsource + image->offset.x;
+    source.y = ysource + image->offset.y;
     source.w = wsource;
     source.h = hsource;
 
@@ -954,11 +1409,14 @@ void SDL::draw (const Image& image, unsigned char alpha,
 
     SDL_SetTextureAlphaMod(image->texture[0], alpha);
     SDL_RenderCopyF(m_renderer, image->texture[0], &source, &target);
-    if (image->highlight[0] != nullptr && highlight_alpha != 0)
-    {
-      SDL_SetTextureAlphaMod(image->highlight[0], highlight_alpha);
-      SDL_RenderCopyF(m_renderer, image->highlight[0], &source, &target);
-    }
+    if (highlight_alpha != 0)
+      if (SDL_Texture* high = highlight (image.get(), 0, image->width, image->height))
+      {
+        source.x = xsource;
+        source.y = ysource;
+        SDL_SetTextureAlphaMod(high, highlight_alpha);
+        SDL_RenderCopyF(m_renderer, high, &source, &target);
+      }
   }
   else
   {
@@ -998,11 +1456,12 @@ void SDL::draw (const Image& image, unsigned char alpha,
 
         SDL_SetTextureAlphaMod(image->texture[idx], alpha);
         SDL_RenderCopyF(m_renderer, image->texture[idx], &inter, &target);
-        if (image->highlight[idx] != nullptr && highlight_alpha != 0)
-        {
-          SDL_SetTextureAlphaMod(image->highlight[idx], highlight_alpha);
-          SDL_RenderCopyF(m_renderer, image->highlight[idx], &inter, &target);
-        }
+        if (highlight_alpha != 0)
+          if (SDL_Texture* high = highlight (image.get(), idx, rect.w, rect.h))
+          {
+            SDL_SetTextureAlphaMod(high, highlight_alpha);
+            SDL_RenderCopyF(m_renderer, high, &inter, &target);
+          }
 
         ++ idx;
       }
@@ -1097,7 +1556,10 @@ void SDL::draw_circle (const int x, const int y, const float radius,
 void SDL::end ()
 {
 #ifndef SOSAGE_GUILESS
+  Uint64 start = SDL_GetPerformanceCounter();
   SDL_RenderPresent (m_renderer);
+  m_present_time = double(SDL_GetPerformanceCounter() - start)
+                   / double(SDL_GetPerformanceFrequency());
 #else
   SDL_Delay(17); // If no GUI, simulate GPU delay
 #endif
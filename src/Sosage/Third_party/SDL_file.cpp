@@ -28,6 +28,19 @@
 #include <Sosage/Third_party/SDL_file.h>
 #include <Sosage/Utils/error.h>
 
+#ifdef SOSAGE_MAP_PACKAGES
+#  ifdef _WIN32
+#    define WIN32_LEAN_AND_MEAN
+#    define NOMINMAX
+#    include <windows.h>
+#  else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#  endif
+#endif
+
 namespace Sosage::Third_party::SDL_file
 {
 
@@ -79,6 +92,99 @@ void close (Asset asset)
   SDL_RWclose (asset.buffer);
 }
 
+Mapping::operator bool() const
+{
+  return (data != nullptr);
+}
+
+#ifdef SOSAGE_MAP_PACKAGES
+#ifdef _WIN32
+Mapping map (const std::string& filename)
+{
+  Mapping out;
+  HANDLE file = CreateFileA (filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return out;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx (file, &size) || size.QuadPart == 0)
+  {
+    CloseHandle (file);
+    return out;
+  }
+
+  HANDLE handle = CreateFileMappingA (file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle (file); // Mapping keeps its own reference to the file
+  if (handle == nullptr)
+    return out;
+
+  void* data = MapViewOfFile (handle, FILE_MAP_READ, 0, 0, 0);
+  if (data == nullptr)
+  {
+    CloseHandle (handle);
+    return out;
+  }
+
+  out.data = static_cast<const char*>(data);
+  out.size = std::size_t(size.QuadPart);
+  out.handle = handle;
+  return out;
+}
+
+void unmap (Mapping& mapping)
+{
+  if (!mapping)
+    return;
+  UnmapViewOfFile (mapping.data);
+  CloseHandle (static_cast<HANDLE>(mapping.handle));
+  mapping = Mapping();
+}
+#else
+Mapping map (const std::string& filename)
+{
+  Mapping out;
+  int fd = ::open (filename.c_str(), O_RDONLY);
+  if (fd == -1)
+    return out;
+
+  struct stat st;
+  if (fstat (fd, &st) == -1 || st.st_size == 0)
+  {
+    ::close (fd);
+    return out;
+  }
+
+  void* data = mmap (nullptr, std::size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close (fd); // Mapping stays valid after closing descriptor
+  if (data == MAP_FAILED)
+    return out;
+
+  out.data = static_cast<const char*>(data);
+  out.size = std::size_t(st.st_size);
+  return out;
+}
+
+void unmap (Mapping& mapping)
+{
+  if (!mapping)
+    return;
+  munmap (const_cast<char*>(mapping.data), mapping.size);
+  mapping = Mapping();
+}
+#endif
+#else
+Mapping map (const std::string&)
+{
+  return Mapping();
+}
+
+void unmap (Mapping& mapping)
+{
+  mapping = Mapping();
+}
+#endif
+
 std::string base_path()
 {
   char* bp = SDL_GetBasePath();
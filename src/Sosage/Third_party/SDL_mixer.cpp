@@ -32,10 +32,89 @@
 
 #ifdef SOSAGE_LINKED_WITH_SDL_MIXER
 
+#ifdef SOSAGE_LINKED_WITH_VORBISFILE
+#include <vorbis/vorbisfile.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#endif
+
 namespace Sosage::Third_party
 {
 
 std::array<bool, Config::sound_channels> SDL_mixer::m_available_channels;
+SDL_mixer::Sound_manager SDL_mixer::m_sounds
+([](Mix_Chunk* chunk) { Mix_FreeChunk (chunk); },
+ [](const Mix_Chunk& chunk) { return std::size_t(chunk.alen); },
+ Config::sound_memory_budget);
+
+#ifdef SOSAGE_LINKED_WITH_VORBISFILE
+
+struct SDL_mixer::Music_stream
+{
+  Asset asset;
+  OggVorbis_File file;
+  SDL_AudioStream* stream = nullptr;
+  long rate = 0;
+  ogg_int64_t length = 0; // in source frames
+
+  bool playing = false;
+  bool paused = false;
+
+  // Starts are applied by the audio thread, shifted by the frames
+  // mixed since the request: tracks started in a row stay aligned even
+  // if the audio callback runs in between
+  bool start_pending = false;
+  double start_position = 0.;
+  std::size_t start_request = 0;
+
+  double volume = 1.;
+  double fade_from = 1.;
+  double fade_to = 1.;
+  std::size_t fade_length = 0; // in output frames
+  std::size_t fade_done = 0;
+  bool stop_after_fade = false;
+
+  double origin = 0.; // in seconds
+  std::size_t played = 0; // output frames played since origin
+
+  double fade_gain() const
+  {
+    if (fade_done >= fade_length)
+      return fade_to;
+    return fade_from + (fade_to - fade_from) * (fade_done / double(fade_length));
+  }
+};
+
+std::vector<SDL_mixer::Music_stream*> SDL_mixer::m_streams;
+std::mutex SDL_mixer::m_streams_mutex;
+std::size_t SDL_mixer::m_mixed_frames = 0;
+int SDL_mixer::m_frequency = 0;
+int SDL_mixer::m_channels = 0;
+
+namespace
+{
+
+std::size_t read_asset (void* ptr, std::size_t size, std::size_t nmemb, void* source)
+{
+  return SDL_RWread (static_cast<Asset*>(source)->base(), ptr, size, nmemb);
+}
+
+int seek_asset (void* source, ogg_int64_t offset, int whence)
+{
+  return (SDL_RWseek (static_cast<Asset*>(source)->base(), offset, whence) < 0 ? -1 : 0);
+}
+
+long tell_asset (void* source)
+{
+  return long(SDL_RWtell (static_cast<Asset*>(source)->base()));
+}
+
+} // namespace
+
+#endif
 
 SDL_mixer::SDL_mixer()
 {
@@ -44,6 +123,13 @@ SDL_mixer::SDL_mixer()
   check (init != -1, "Cannot initialized SDL Mixer (" + std::string(Mix_GetError() )+ ")");
   Mix_AllocateChannels (Config::sound_channels);
 
+#ifdef SOSAGE_LINKED_WITH_VORBISFILE
+  Uint16 format;
+  Mix_QuerySpec (&m_frequency, &format, &m_channels);
+  check (format == AUDIO_S16SYS, "Unsupported audio format for music streaming");
+  Mix_HookMusic (mix_streams, nullptr);
+#endif
+
   for (std::size_t i = 0; i < Config::sound_channels; ++ i)
   {
     m_available_channels[i] = true;
@@ -58,31 +144,240 @@ SDL_mixer::SDL_mixer()
 
 SDL_mixer::~SDL_mixer()
 {
+  m_sounds.clear();
+#ifdef SOSAGE_LINKED_WITH_VORBISFILE
+  Mix_HookMusic (nullptr, nullptr);
+#endif
   Mix_CloseAudio ();
 }
 
+#ifdef SOSAGE_LINKED_WITH_VORBISFILE
+
+SDL_mixer::Music SDL_mixer::load_music (const std::string& file_name)
+{
+  // Owned here until registered, so that nothing leaks if a check fails
+  auto music = std::make_unique<Music_stream>();
+  music->asset = Asset_manager::open(file_name);
+  check (music->asset, "Cannot load music " + file_name);
+
+  ov_callbacks callbacks = { read_asset, seek_asset, nullptr, tell_asset };
+  int error = ov_open_callbacks (&music->asset, &music->file, nullptr, 0, callbacks);
+  if (error != 0)
+    music->asset.close();
+  check (error == 0, "Cannot decode music " + file_name);
+
+  vorbis_info* info = ov_info (&music->file, -1);
+  music->rate = info->rate;
+  music->length = ov_pcm_total (&music->file, -1);
+  music->stream = SDL_NewAudioStream (AUDIO_S16SYS, Uint8(info->channels), int(info->rate),
+                                      AUDIO_S16SYS, Uint8(m_channels), m_frequency);
+  if (music->stream == nullptr)
+  {
+    ov_clear (&music->file);
+    music->asset.close();
+  }
+  check (music->stream != nullptr, "Cannot create audio stream (" + std::string(SDL_GetError()) + ")");
+
+  std::lock_guard<std::mutex> lock (m_streams_mutex);
+  m_streams.push_back (music.get());
+  return music.release();
+}
+
+#else
+
 SDL_mixer::Music SDL_mixer::load_music (const std::string& file_name)
 {
-  return load_sound(file_name);
+  return decode_sound(file_name);
 }
 
+#endif
+
 SDL_mixer::Sound SDL_mixer::load_sound (const std::string& file_name)
 {
-  Asset asset = Asset_manager::open(file_name);
-  Mix_Chunk* sound = Mix_LoadWAV_RW (asset.base(), 0);
-  asset.close();
-  check (sound != nullptr, "Cannot load sound " + file_name);
-  return sound;
+  return m_sounds.make_mapped (file_name, decode_sound, file_name);
 }
 
+#ifdef SOSAGE_LINKED_WITH_VORBISFILE
+
 void SDL_mixer::delete_music (SDL_mixer::Music& music)
 {
-  delete_sound(music);
+  {
+    std::lock_guard<std::mutex> lock (m_streams_mutex);
+    m_streams.erase (std::find (m_streams.begin(), m_streams.end(), music));
+  }
+  ov_clear (&music->file);
+  SDL_FreeAudioStream (music->stream);
+  music->asset.close();
+  delete music;
+  music = nullptr;
+}
+
+void SDL_mixer::set_music_channels (std::size_t)
+{
+  // Streamed musics do not use mixer channels
 }
 
-void SDL_mixer::delete_sound (SDL_mixer::Sound& sound)
+void SDL_mixer::start_music (const SDL_mixer::Music& music, int, double volume)
+{
+  debug << "Start music with volume " << volume << "%" << std::endl;
+  std::lock_guard<std::mutex> lock (m_streams_mutex);
+  music->volume = volume;
+  music->fade_from = music->fade_to = 1.;
+  music->fade_length = music->fade_done = 0;
+  request_start (music, 0.);
+}
+
+void SDL_mixer::stop_music(const SDL_mixer::Music& music, int)
+{
+  debug << "Stop music" << std::endl;
+  std::lock_guard<std::mutex> lock (m_streams_mutex);
+  music->playing = false;
+  music->start_pending = false;
+}
+
+void SDL_mixer::fade (const SDL_mixer::Music& music, int,
+                      double time, bool in, double position)
+{
+  std::lock_guard<std::mutex> lock (m_streams_mutex);
+  if (in)
+  {
+    debug << "Fade in music " << time << std::endl;
+    request_start (music, position);
+    music->fade_from = 0.;
+  }
+  else
+  {
+    debug << "Fade out music" << std::endl;
+    music->fade_from = music->fade_gain();
+    music->stop_after_fade = true;
+  }
+  music->fade_to = (in ? 1. : 0.);
+  music->fade_length = std::size_t(time * m_frequency);
+  music->fade_done = 0;
+}
+
+void SDL_mixer::set_volume (const SDL_mixer::Music& music, int, double percentage)
+{
+  debug << "Set volume to " << percentage << "%" << std::endl;
+  std::lock_guard<std::mutex> lock (m_streams_mutex);
+  music->volume = percentage;
+}
+
+void SDL_mixer::pause_music (const SDL_mixer::Music& music, int)
 {
-  Mix_FreeChunk (sound);
+  debug << "Pause music" << std::endl;
+  std::lock_guard<std::mutex> lock (m_streams_mutex);
+  music->paused = true;
+}
+
+void SDL_mixer::resume_music (const SDL_mixer::Music& music, int)
+{
+  debug << "Resume music" << std::endl;
+  std::lock_guard<std::mutex> lock (m_streams_mutex);
+  music->paused = false;
+}
+
+double SDL_mixer::position (const SDL_mixer::Music& music) const
+{
+  std::lock_guard<std::mutex> lock (m_streams_mutex);
+  if (music->length == 0)
+    return 0.;
+  if (music->start_pending)
+    return music->start_position;
+  double position = music->origin + music->played / double(m_frequency);
+  return std::fmod (position, music->length / double(music->rate));
+}
+
+void SDL_mixer::request_start (Music_stream* music, double position)
+{
+  music->playing = true;
+  music->paused = false;
+  music->stop_after_fade = false;
+  music->start_pending = true;
+  music->start_position = position;
+  music->start_request = m_mixed_frames;
+}
+
+void SDL_mixer::seek (Music_stream* music, double position)
+{
+  ogg_int64_t frame = ogg_int64_t(position * music->rate);
+  if (music->length != 0)
+    frame %= music->length;
+  ov_pcm_seek (&music->file, frame);
+  SDL_AudioStreamClear (music->stream);
+  music->origin = frame / double(music->rate);
+  music->played = 0;
+}
+
+void SDL_mixer::read_stream (Music_stream* music, Sint16* out, std::size_t nb_frames)
+{
+  int needed = int(nb_frames * m_channels * sizeof(Sint16));
+  char chunk[4096];
+  while (music->length != 0 && SDL_AudioStreamAvailable (music->stream) < needed)
+  {
+    int bitstream;
+    long read = ov_read (&music->file, chunk, int(sizeof(chunk)),
+                         (SDL_BYTEORDER == SDL_BIG_ENDIAN ? 1 : 0), 2, 1, &bitstream);
+    if (read == 0) // end of track, loop
+      ov_pcm_seek (&music->file, 0);
+    else if (read < 0) // corrupted data, skip
+      break;
+    else
+      SDL_AudioStreamPut (music->stream, chunk, int(read));
+  }
+
+  int got = SDL_AudioStreamGet (music->stream, out, needed);
+  if (got < needed)
+    std::memset (reinterpret_cast<char*>(out) + std::max(got, 0), 0, std::size_t(needed - std::max(got, 0)));
+}
+
+void SDL_mixer::mix_streams (void*, Uint8* stream, int len)
+{
+  std::lock_guard<std::mutex> lock (m_streams_mutex);
+
+  std::size_t nb_frames = std::size_t(len) / (m_channels * sizeof(Sint16));
+  static std::vector<Sint16> buffer; // only used by audio thread
+  buffer.resize (nb_frames * m_channels);
+  Sint16* out = reinterpret_cast<Sint16*>(stream);
+
+  for (Music_stream* music : m_streams)
+  {
+    if (!music->playing || music->paused)
+      continue;
+
+    if (music->start_pending)
+    {
+      seek (music, music->start_position + (m_mixed_frames - music->start_request) / double(m_frequency));
+      music->start_pending = false;
+    }
+
+    read_stream (music, buffer.data(), nb_frames);
+    for (std::size_t f = 0; f < nb_frames; ++ f)
+    {
+      double gain = music->volume * music->fade_gain();
+      if (music->fade_done < music->fade_length)
+        ++ music->fade_done;
+      for (int c = 0; c < m_channels; ++ c)
+      {
+        std::size_t idx = f * m_channels + c;
+        int value = out[idx] + int(std::lround (buffer[idx] * gain));
+        out[idx] = Sint16(std::clamp (value, -32768, 32767));
+      }
+    }
+    music->played += nb_frames;
+
+    if (music->stop_after_fade && music->fade_done >= music->fade_length)
+      music->playing = false;
+  }
+
+  m_mixed_frames += nb_frames;
+}
+
+#else
+
+void SDL_mixer::delete_music (SDL_mixer::Music& music)
+{
+  Mix_FreeChunk (music);
 }
 
 void SDL_mixer::set_music_channels (std::size_t nb)
@@ -143,6 +438,30 @@ void SDL_mixer::resume_music (const SDL_mixer::Music&, int channel)
   Mix_Resume(m_music_channels[channel]);
 }
 
+double SDL_mixer::position (const SDL_mixer::Music&) const
+{
+  return 0.; // Not available
+}
+
+#endif
+
+void SDL_mixer::delete_sound (SDL_mixer::Sound& sound)
+{
+  sound.reset();
+}
+
+void SDL_mixer::clear_managers()
+{
+  m_sounds.shrink();
+  debug << "Sound cache: " << m_sounds.size() << " sounds using "
+        << m_sounds.memory() / (1024 * 1024) << "MB" << std::endl;
+}
+
+void SDL_mixer::pin_new_resources (bool pin)
+{
+  m_sounds.pin_new_resources (pin);
+}
+
 void SDL_mixer::play_sound (const SDL_mixer::Sound& sound, double volume, double panning)
 {
   int channel = reserve_channel();
@@ -150,12 +469,7 @@ void SDL_mixer::play_sound (const SDL_mixer::Sound& sound, double volume, double
   int right= int((1. - panning) * Config::max_panning);
   Mix_Volume (channel, volume * Config::max_music_volume);
   Mix_SetPanning(channel, left, right);
-  Mix_PlayChannel(channel, sound, 0);
-}
-
-double SDL_mixer::position (const SDL_mixer::Music&) const
-{
-  return 0.; // Not available
+  Mix_PlayChannel(channel, sound.get(), 0);
 }
 
 int SDL_mixer::reserve_channel()
@@ -170,6 +484,15 @@ int SDL_mixer::reserve_channel()
   return -1;
 }
 
+Mix_Chunk* SDL_mixer::decode_sound (const std::string& file_name)
+{
+  Asset asset = Asset_manager::open(file_name);
+  Mix_Chunk* sound = Mix_LoadWAV_RW (asset.base(), 0);
+  asset.close();
+  check (sound != nullptr, "Cannot load sound " + file_name);
+  return sound;
+}
+
 } // namespace Sosage::Third_party
 
 #endif
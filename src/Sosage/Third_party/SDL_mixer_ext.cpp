@@ -36,6 +36,10 @@ namespace Sosage::Third_party
 {
 
 std::array<bool, Config::sound_channels> SDL_mixer_ext::m_available_channels;
+SDL_mixer_ext::Sound_manager SDL_mixer_ext::m_sounds
+([](Mix_Chunk* chunk) { Mix_FreeChunk (chunk); },
+ [](const Mix_Chunk& chunk) { return std::size_t(chunk.alen); },
+ Config::sound_memory_budget);
 
 SDL_mixer_ext::SDL_mixer_ext()
 {
@@ -57,6 +61,7 @@ SDL_mixer_ext::SDL_mixer_ext()
 
 SDL_mixer_ext::~SDL_mixer_ext()
 {
+  m_sounds.clear();
   Mix_CloseAudio ();
 }
 
@@ -70,11 +75,7 @@ SDL_mixer_ext::Music SDL_mixer_ext::load_music (const std::string& file_name)
 
 SDL_mixer_ext::Sound SDL_mixer_ext::load_sound (const std::string& file_name)
 {
-  Asset asset = Asset_manager::open(file_name);
-  Mix_Chunk* sound = Mix_LoadWAV_RW (asset.base(), 0);
-  asset.close();
-  check (sound != nullptr, "Cannot load sound " + file_name);
-  return sound;
+  return m_sounds.make_mapped (file_name, decode_sound, file_name);
 }
 
 void SDL_mixer_ext::delete_music (SDL_mixer_ext::Music& music)
@@ -85,7 +86,19 @@ void SDL_mixer_ext::delete_music (SDL_mixer_ext::Music& music)
 
 void SDL_mixer_ext::delete_sound (SDL_mixer_ext::Sound& sound)
 {
-  Mix_FreeChunk (sound);
+  sound.reset();
+}
+
+void SDL_mixer_ext::clear_managers()
+{
+  m_sounds.shrink();
+  debug << "Sound cache: " << m_sounds.size() << " sounds using "
+        << m_sounds.memory() / (1024 * 1024) << "MB" << std::endl;
+}
+
+void SDL_mixer_ext::pin_new_resources (bool pin)
+{
+  m_sounds.pin_new_resources (pin);
 }
 
 void SDL_mixer_ext::set_music_channels (std::size_t)
@@ -148,7 +161,7 @@ void SDL_mixer_ext::play_sound (const SDL_mixer_ext::Sound& sound, double volume
   int right= int((1. - panning) * Config::max_panning);
   Mix_Volume (channel, volume * Config::max_sound_volume);
   Mix_SetPanning(channel, left, right);
-  Mix_PlayChannel(channel, sound, 0);
+  Mix_PlayChannel(channel, sound.get(), 0);
 }
 
 double SDL_mixer_ext::position (const SDL_mixer_ext::Music& music) const
@@ -167,6 +180,15 @@ int SDL_mixer_ext::reserve_channel()
   return -1;
 }
 
+Mix_Chunk* SDL_mixer_ext::decode_sound (const std::string& file_name)
+{
+  Asset asset = Asset_manager::open(file_name);
+  Mix_Chunk* sound = Mix_LoadWAV_RW (asset.base(), 0);
+  asset.close();
+  check (sound != nullptr, "Cannot load sound " + file_name);
+  return sound;
+}
+
 } // namespace Sosage::Third_party
 
 #endif
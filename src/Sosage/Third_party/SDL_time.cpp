@@ -43,4 +43,9 @@ void SDL_time::wait (const Duration& d)
   SDL_Delay (d);
 }
 
+double SDL_time::precise_now()
+{
+  return SDL_GetPerformanceCounter() / double(SDL_GetPerformanceFrequency());
+}
+
 } // namespace Sosage::Third_party
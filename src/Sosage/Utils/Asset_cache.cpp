@@ -0,0 +1,108 @@
+/*
+  [src/Sosage/Utils/Asset_cache.cpp]
+  Bounded cache of decompressed assets.
+
+  =====================================================================
+
+  This file is part of SOSAGE.
+
+  SOSAGE is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SOSAGE is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with SOSAGE.  If not, see <https://www.gnu.org/licenses/>.
+
+  =====================================================================
+
+  Author(s): Simon Giraudot <sosage@ptilouk.net>
+*/
+
+#include <Sosage/Utils/Asset_cache.h>
+
+#include <cstring>
+
+namespace Sosage
+{
+
+std::mutex Asset_cache::m_mutex;
+std::unordered_map<std::string, Asset_cache::Entry> Asset_cache::m_entries;
+Asset_cache::LRU_list Asset_cache::m_lru;
+std::size_t Asset_cache::m_size = 0;
+std::size_t Asset_cache::m_hits = 0;
+std::size_t Asset_cache::m_misses = 0;
+
+bool Asset_cache::contains (const std::string& key)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  return m_entries.find(key) != m_entries.end();
+}
+
+bool Asset_cache::fetch (const std::string& key, void* memory, std::size_t size)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  auto iter = m_entries.find(key);
+  if (iter == m_entries.end() || iter->second.data.size() != size)
+  {
+    ++ m_misses;
+    return false;
+  }
+
+  ++ m_hits;
+  std::memcpy (memory, iter->second.data.data(), size);
+  m_lru.splice (m_lru.begin(), m_lru, iter->second.lru);
+  return true;
+}
+
+void Asset_cache::insert (const std::string& key, Buffer&& data)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  if (data.size() > Config::asset_cache_budget || m_entries.find(key) != m_entries.end())
+    return;
+
+  while (m_size + data.size() > Config::asset_cache_budget)
+  {
+    auto iter = m_entries.find (m_lru.back());
+    m_size -= iter->second.data.size();
+    m_entries.erase (iter);
+    m_lru.pop_back();
+  }
+
+  m_lru.push_front (key);
+  m_size += data.size();
+  m_entries.insert (std::make_pair (key, Entry{ std::move(data), m_lru.begin() }));
+}
+
+void Asset_cache::clear()
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  m_entries.clear();
+  m_lru.clear();
+  m_size = 0;
+}
+
+std::size_t Asset_cache::size()
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  return m_size;
+}
+
+std::size_t Asset_cache::hits()
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  return m_hits;
+}
+
+std::size_t Asset_cache::misses()
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  return m_misses;
+}
+
+} // namespace Sosage
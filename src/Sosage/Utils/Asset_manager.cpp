@@ -25,12 +25,18 @@
   */
 
 #include <Sosage/Third_party/LZ4.h>
+#include <Sosage/Utils/Asset_cache.h>
 #include <Sosage/Utils/Asset_manager.h>
 #include <Sosage/Utils/conversions.h>
 #include <Sosage/Utils/error.h>
 #include <Sosage/Utils/image_split.h>
 #include <Sosage/Utils/profiling.h>
 
+#include <algorithm>
+#ifdef SOSAGE_SCAP
+#include <fstream>
+#endif
+
 namespace Sosage
 {
 
@@ -47,11 +53,12 @@ Asset::Asset (Buffer* buffer)
 }
 
 Asset::Asset (const void* memory, std::size_t size)
+  : m_buffer(nullptr)
 {
   m_base = IO::open(memory, size);
 }
 
-Asset::Asset() { }
+Asset::Asset() : m_buffer(nullptr) { }
 
 Asset::operator bool() const
 {
@@ -130,128 +137,29 @@ bool Asset_manager::init (const std::string& folder, bool scap_mode)
     std::size_t buffer_id = 0;
     for (const std::string& package : packages)
     {
-      Asset asset = open (package + ".data", true);
+      Package_buffer& pbuffer = buffers[buffer_id];
+#ifdef SOSAGE_MAP_PACKAGES
+      pbuffer.mapping = IO::map (local_file_name (package + ".data"));
+      if (!pbuffer.mapping)
+        debug << "Can't map " << package << ".data, loading it in memory" << std::endl;
+#endif
+      Asset asset = (pbuffer.mapping ? Asset (pbuffer.mapping.data, pbuffer.mapping.size)
+                                     : open (package + ".data", true));
 
       std::size_t end = 0;
-      while (true)
+      if (!read_index (asset, buffer_id, package_asset_map, end))
       {
-        auto path_size = asset.binary_read<unsigned char>();
-        if (path_size == 0)
-          break;
-
-        Buffer path (path_size);
-        asset.binary_read(path);
-        std::string fname = std::string (path.begin(), path.end());
-
-        Packaged_asset passet;
-        passet.buffer_id = buffer_id;
-
-        auto ext = fname.find(".sdl_surface.lz4");
-        if (ext != std::string::npos) // custom surface
-        {
-          fname.resize(ext);
-          fname = fname + ".png";
-          passet.width = asset.binary_read<unsigned short>();
-          passet.height = asset.binary_read<unsigned short>();
-          passet.format = asset.binary_read<unsigned int>();
-          SDL_PixelFormat* pixel_format = SDL_AllocFormat(passet.format);
-          unsigned int bpp = (unsigned int)(pixel_format->BytesPerPixel);
-          SDL_FreeFormat(pixel_format);
-
-          bool is_object = contains(fname, "images/objects") ||
-                           contains(fname, "images/interface") ||
-                           contains(fname, "images/inventory") ||
-                           contains(fname, "images/masks");
-
-          bool is_map = endswith (fname, "_map.png");
-
-          Uint32 nb_x = 1;
-          Uint32 nb_y = 1;
-          if (!is_map)
-          {
-            nb_x = Splitter::nb_sub (passet.width);
-            nb_y = Splitter::nb_sub (passet.height);
-          }
-
-          for (Uint32 x = 0; x < nb_x; ++ x)
-          {
-            for (Uint32 y = 0; y < nb_y; ++ y)
-            {
-              SDL_Rect rect;
-              rect.x = 0; rect.y = 0; rect.w = passet.width; rect.h = passet.height;
-              if (!is_map)
-                rect = Splitter::rect (passet.width, passet.height, x, y);
-
-              Packaged_asset lpasset;
-              lpasset.buffer_id = buffer_id;
-              lpasset.width = rect.w;
-              lpasset.height = rect.h;
-              lpasset.format = passet.format;
-              lpasset.size = bpp * lpasset.width * lpasset.height;
-              lpasset.compressed_size = asset.binary_read<unsigned int>();
-              lpasset.position = asset.tell();
-              end = lpasset.position + lpasset.compressed_size;
-              asset.seek(end);
-
-              std::string lfname = fname + "." + std::to_string(x)
-                      + "x" + std::to_string(y);
-              package_asset_map.insert (std::make_pair (lfname, lpasset));
-
-              if (is_object)
-              {
-                Packaged_asset lpasset;
-                lpasset.buffer_id = buffer_id;
-                lpasset.width = rect.w;
-                lpasset.height = rect.h;
-                lpasset.format = passet.format;
-                lpasset.size = bpp * lpasset.width * lpasset.height;
-                lpasset.compressed_size = asset.binary_read<unsigned int>();
-                lpasset.position = asset.tell();
-                end = lpasset.position + lpasset.compressed_size;
-                asset.seek(end);
-
-                std::string lfname = fname + "." + std::to_string(x)
-                        + "x" + std::to_string(y) + ".HL";
-                package_asset_map.insert (std::make_pair (lfname, lpasset));
-              }
-            }
-          }
-
-          if (is_object)
-          {
-            Packaged_asset lpasset;
-            lpasset.buffer_id = buffer_id;
-            lpasset.size = asset.binary_read<unsigned int>();
-            lpasset.compressed_size = asset.binary_read<unsigned int>();
-            lpasset.position = asset.tell();
-            end = lpasset.position + lpasset.compressed_size;
-            asset.seek(end);
-            std::string lfname = fname + ".mask";
-            package_asset_map.insert (std::make_pair (lfname, lpasset));
-          }
-        }
-        else if (!contains (fname, ".lz4")) // uncompressed file
-        {
-          passet.size = asset.binary_read<unsigned int>();
-          passet.position = asset.tell();
-          end = passet.position + passet.size;
-          asset.seek(end);
-        }
-        else
-        {
-          passet.size = asset.binary_read<unsigned int>();
-          passet.compressed_size = asset.binary_read<unsigned int>();
-          passet.position = asset.tell();
-          end = passet.position + passet.compressed_size;
-          asset.seek(end);
-          fname.resize(fname.size() - 4);
-        }
-        package_asset_map.insert (std::make_pair (fname, passet));
+        debug << "No index found in " << package << ".data, scanning records" << std::endl;
+        end = read_records (asset, buffer_id, package_asset_map);
       }
 
-      asset.seek(0);
-      buffers[buffer_id].resize(end);
-      asset.read(buffers[buffer_id].data(), end);
+      // Mapped packages are read directly when assets are requested
+      if (!pbuffer.mapping)
+      {
+        asset.seek(0);
+        pbuffer.buffer.resize(end);
+        asset.read(pbuffer.buffer.data(), end);
+      }
       asset.close();
 
       ++ buffer_id;
@@ -271,6 +179,211 @@ bool Asset_manager::init (const std::string& folder, bool scap_mode)
   return true;
 }
 
+std::size_t Asset_manager::read_records (Asset& asset, std::size_t buffer_id,
+                                         Package_asset_map& map)
+{
+  std::size_t end = 0;
+  while (true)
+  {
+    auto path_size = asset.binary_read<unsigned char>();
+    if (path_size == 0)
+      break;
+
+    Buffer path (path_size);
+    asset.binary_read(path);
+    std::string fname = std::string (path.begin(), path.end());
+
+    Packaged_asset passet;
+    passet.buffer_id = buffer_id;
+
+    auto ext = fname.find(".sdl_surface.lz4");
+    if (ext != std::string::npos) // custom surface
+    {
+      fname.resize(ext);
+      fname = fname + ".png";
+      passet.width = asset.binary_read<unsigned short>();
+      passet.height = asset.binary_read<unsigned short>();
+      passet.format = asset.binary_read<unsigned int>();
+      SDL_PixelFormat* pixel_format = SDL_AllocFormat(passet.format);
+      unsigned int bpp = (unsigned int)(pixel_format->BytesPerPixel);
+      SDL_FreeFormat(pixel_format);
+
+      bool with_mask = contains(fname, "images/objects") ||
+                       contains(fname, "images/interface") ||
+                       contains(fname, "images/inventory") ||
+                       contains(fname, "images/masks");
+
+      bool is_map = endswith (fname, "_map.png");
+
+      Uint32 nb_x = 1;
+      Uint32 nb_y = 1;
+      if (!is_map)
+      {
+        nb_x = Splitter::nb_sub (passet.width);
+        nb_y = Splitter::nb_sub (passet.height);
+      }
+
+      for (Uint32 x = 0; x < nb_x; ++ x)
+      {
+        for (Uint32 y = 0; y < nb_y; ++ y)
+        {
+          SDL_Rect rect;
+          rect.x = 0; rect.y = 0; rect.w = passet.width; rect.h = passet.height;
+          if (!is_map)
+            rect = Splitter::rect (passet.width, passet.height, x, y);
+
+          Packaged_asset lpasset;
+          lpasset.buffer_id = buffer_id;
+          lpasset.width = rect.w;
+          lpasset.height = rect.h;
+          lpasset.format = passet.format;
+          lpasset.size = bpp * lpasset.width * lpasset.height;
+          lpasset.compressed_size = asset.binary_read<unsigned int>();
+          lpasset.codec = asset.binary_read<Codec>();
+          lpasset.position = asset.tell();
+          end = lpasset.position + lpasset.compressed_size;
+          asset.seek(end);
+
+          std::string lfname = fname + "." + std::to_string(x)
+                  + "x" + std::to_string(y);
+          map.insert (std::make_pair (lfname, lpasset));
+        }
+      }
+
+      if (with_mask)
+      {
+        Packaged_asset lpasset;
+        lpasset.buffer_id = buffer_id;
+        lpasset.size = asset.binary_read<unsigned int>();
+        lpasset.compressed_size = asset.binary_read<unsigned int>();
+        lpasset.codec = asset.binary_read<Codec>();
+        lpasset.position = asset.tell();
+        end = lpasset.position + lpasset.compressed_size;
+        asset.seek(end);
+        std::string lfname = fname + ".mask";
+        map.insert (std::make_pair (lfname, lpasset));
+      }
+    }
+    else if (!contains (fname, ".lz4")) // uncompressed file
+    {
+      passet.size = asset.binary_read<unsigned int>();
+      passet.compressed_size = passet.size;
+      passet.position = asset.tell();
+      end = passet.position + passet.size;
+      asset.seek(end);
+    }
+    else
+    {
+      passet.size = asset.binary_read<unsigned int>();
+      passet.compressed_size = asset.binary_read<unsigned int>();
+      passet.codec = asset.binary_read<Codec>();
+      passet.position = asset.tell();
+      end = passet.position + passet.compressed_size;
+      asset.seek(end);
+      fname.resize(fname.size() - 4);
+    }
+    map.insert (std::make_pair (fname, passet));
+  }
+  return end;
+}
+
+bool Asset_manager::read_index (Asset& asset, std::size_t buffer_id,
+                                Package_asset_map& map, std::size_t& end)
+{
+  std::size_t footer_size = 2 * sizeof(unsigned int) + Config::package_index_magic.size();
+  if (asset.size() < footer_size)
+    return false;
+
+  asset.seek (asset.size() - Config::package_index_magic.size());
+  Buffer magic (Config::package_index_magic.size());
+  asset.binary_read (magic);
+  if (std::string (magic.begin(), magic.end()) != Config::package_index_magic)
+    return false;
+
+  asset.seek (asset.size() - footer_size);
+  auto nb_entries = asset.binary_read<unsigned int>();
+  auto index_position = asset.binary_read<unsigned int>();
+
+  // Whole index is read at once and parsed from memory
+  Buffer index (asset.size() - footer_size - index_position);
+  asset.seek (index_position);
+  asset.binary_read (index);
+  Asset iasset (index.data(), index.size());
+
+  map.reserve (map.size() + nb_entries);
+  for (unsigned int i = 0; i < nb_entries; ++ i)
+  {
+    auto key_size = iasset.binary_read<unsigned char>();
+    Buffer key (key_size);
+    iasset.binary_read (key);
+
+    Packaged_asset passet;
+    passet.buffer_id = buffer_id;
+    passet.position = iasset.binary_read<unsigned int>();
+    passet.compressed_size = iasset.binary_read<unsigned int>();
+    passet.size = iasset.binary_read<unsigned int>();
+    passet.codec = iasset.binary_read<Codec>();
+    passet.width = iasset.binary_read<unsigned short>();
+    passet.height = iasset.binary_read<unsigned short>();
+    passet.format = iasset.binary_read<unsigned int>();
+    map.insert (std::make_pair (std::string (key.begin(), key.end()), passet));
+  }
+  iasset.close();
+
+  // Payload stops right before the index
+  end = index_position;
+  return true;
+}
+
+#ifdef SOSAGE_SCAP
+void Asset_manager::append_index (const std::string& package_file)
+{
+  Asset asset (package_file);
+  check (asset, "Can't open package " + package_file);
+  Package_asset_map map;
+  std::size_t end = read_records (asset, 0, map);
+  asset.close();
+
+  // Sorted keys make the index deterministic
+  std::vector<const Package_asset_map::value_type*> entries;
+  entries.reserve (map.size());
+  for (const auto& m : map)
+    entries.push_back (&m);
+  std::sort (entries.begin(), entries.end(),
+             [](const auto* a, const auto* b) -> bool { return a->first < b->first; });
+
+  std::ofstream ofile (package_file, std::ios::binary | std::ios::app);
+  // Index starts right after the zero-size path that ends records
+  std::size_t index_position = end + 1;
+  for (const auto* e : entries)
+  {
+    const std::string& key = e->first;
+    const Packaged_asset& passet = e->second;
+    check (key.size() < 256, "Index key exceeds 255 char limit: " + key);
+    binary_write (ofile, (unsigned char)(key.size()));
+    binary_write (ofile, key);
+    binary_write (ofile, passet.position);
+    binary_write (ofile, passet.compressed_size);
+    binary_write (ofile, passet.size);
+    binary_write (ofile, passet.codec);
+    binary_write (ofile, passet.width);
+    binary_write (ofile, passet.height);
+    binary_write (ofile, passet.format);
+  }
+  binary_write (ofile, entries.size());
+  binary_write (ofile, index_position);
+  binary_write (ofile, std::string(Config::package_index_magic));
+}
+#endif
+
+void Asset_manager::shutdown()
+{
+  package_asset_map.clear();
+  for (Package_buffer& pbuffer : buffers)
+    IO::unmap (pbuffer.mapping);
+  buffers.clear();
+}
+
 Asset Asset_manager::open_pref (const std::string& filename, bool write)
 {
   return Asset (IO::pref_path() + filename, write);
@@ -287,12 +400,13 @@ Asset Asset_manager::open (const std::string& filename, bool file_is_package)
       return Asset();
     }
     Packaged_asset& asset = iter->second;
-    if (asset.compressed_size == 0) // uncompressed file
+    if (asset.codec == CODEC_STORED) // read directly from package
       return Asset (buffers[asset.buffer_id].data() + asset.position, asset.size);
     // else
     Buffer* buffer = new Buffer(asset.size);
-    lz4_decompress_buffer (buffers[asset.buffer_id].data() + asset.position, asset.compressed_size,
-        buffer->data(), asset.size);
+    if (!Asset_cache::fetch (filename, buffer->data(), asset.size))
+      decompress_buffer (asset.codec, buffers[asset.buffer_id].data() + asset.position,
+                         asset.compressed_size, buffer->data(), asset.size);
     return Asset (buffer);
   }
   // else
@@ -323,17 +437,56 @@ std::tuple<int, int, int> Asset_manager::image_info (const std::string& filename
   return std::make_tuple(asset.width, asset.height, asset.format);
 }
 
-void Asset_manager::open (const std::string& filename, void* memory, Uint32 x, Uint32 y, bool highlight)
+void Asset_manager::open (const std::string& filename, void* memory, Uint32 x, Uint32 y)
 {
   std::string fname = filename + "." + std::to_string(x) + "x" + std::to_string(y);
-  if (highlight)
-    fname += ".HL";
   auto iter = package_asset_map.find(fname);
   check (iter != package_asset_map.end(), "Packaged asset " + fname + " not found");
   Packaged_asset& asset = iter->second;
 
-  lz4_decompress_buffer (buffers[asset.buffer_id].data() + asset.position, asset.compressed_size,
-      memory, asset.size);
+  if (!Asset_cache::fetch (fname, memory, asset.size))
+    decompress_buffer (asset.codec, buffers[asset.buffer_id].data() + asset.position,
+                       asset.compressed_size, memory, asset.size);
+}
+
+void Asset_manager::prefetch (const std::string& filename)
+{
+  if (!packaged())
+    return;
+
+  auto decompress = [](const std::string& key)
+  {
+    auto iter = package_asset_map.find(key);
+    if (iter == package_asset_map.end() || iter->second.codec == CODEC_STORED
+        || Asset_cache::contains(key))
+      return;
+    const Packaged_asset& asset = iter->second;
+    Buffer buffer (asset.size);
+    decompress_buffer (asset.codec, buffers[asset.buffer_id].data() + asset.position,
+                       asset.compressed_size, buffer.data(), asset.size);
+    Asset_cache::insert (key, std::move(buffer));
+  };
+
+  auto iter = package_asset_map.find(filename);
+  if (iter == package_asset_map.end())
+    return;
+
+  // Images are stored as tiles (+ mask)
+  if (iter->second.width != 0)
+  {
+    Uint32 nb_x = Splitter::nb_sub (iter->second.width);
+    Uint32 nb_y = Splitter::nb_sub (iter->second.height);
+    if (endswith (filename, "_map.png"))
+      nb_x = nb_y = 1;
+    for (Uint32 x = 0; x < nb_x; ++ x)
+      for (Uint32 y = 0; y < nb_y; ++ y)
+      {
+        decompress (filename + "." + std::to_string(x) + "x" + std::to_string(y));
+      }
+    decompress (filename + ".mask");
+  }
+  else
+    decompress (filename);
 }
 
 const Package_asset_map& Asset_manager::asset_map()
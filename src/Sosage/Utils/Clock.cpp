@@ -30,6 +30,7 @@
 #include <Sosage/Utils/profiling.h>
 
 #include <cmath>
+#include <thread>
 
 namespace Sosage
 {
@@ -79,6 +80,19 @@ void Clock::sleep (double time)
   m_time = (Time::now() - m_start) / 1000.;
 }
 
+void Clock::precise_sleep (double time)
+{
+  // OS sleeps are only accurate to a millisecond or so: sleep until
+  // close to the deadline, then spin
+  double deadline = Time::precise_now() + time;
+  double coarse = time - Config::sleep_spin_margin;
+  if (coarse > 0.)
+    Time::wait (Time::Duration(coarse * 1000.));
+  while (Time::precise_now() < deadline)
+    std::this_thread::yield();
+  m_time = (Time::now() - m_start) / 1000.;
+}
+
 double Clock::fps() const
 {
   return m_fps;
@@ -0,0 +1,114 @@
+/*
+  [src/Sosage/Utils/Symbol.cpp]
+  Interned strings used as entity and component names.
+
+  =====================================================================
+
+  This file is part of SOSAGE.
+
+  SOSAGE is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SOSAGE is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with SOSAGE.  If not, see <https://www.gnu.org/licenses/>.
+
+  =====================================================================
+
+  Author(s): Simon Giraudot <sosage@ptilouk.net>
+*/
+
+#include <Sosage/Utils/Symbol.h>
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace Sosage
+{
+
+Symbol::Symbol()
+  : m_str (intern (std::string_view()))
+{ }
+
+Symbol::Symbol (const std::string& str)
+  : m_str (intern (str))
+{ }
+
+Symbol::Symbol (const char* str)
+  : m_str (intern (std::string_view(str)))
+{ }
+
+Symbol Symbol::operator+ (const char* suffix) const
+{
+  using Key = std::pair<const std::string*, const std::string*>;
+  struct Key_hash
+  {
+    std::size_t operator() (const Key& k) const
+    { return std::hash<const std::string*>()(k.first) ^ (std::hash<const std::string*>()(k.second) << 1); }
+  };
+  static std::unordered_map<Key, Symbol, Key_hash> concatenations;
+  static std::shared_mutex mutex;
+
+  Key key (m_str, Symbol(suffix).m_str);
+  {
+    std::shared_lock<std::shared_mutex> lock (mutex);
+    auto iter = concatenations.find (key);
+    if (iter != concatenations.end())
+      return iter->second;
+  }
+
+  Symbol out (*m_str + *key.second);
+  std::unique_lock<std::shared_mutex> lock (mutex);
+  concatenations.insert (std::make_pair (key, out));
+  return out;
+}
+
+const std::string* Symbol::intern (std::string_view str)
+{
+  // Names are looked up by view, so that literals are not copied in
+  // a temporary string, and first in a table local to the thread, so
+  // that known names are found without locking
+  thread_local std::unordered_map<std::string_view, const std::string*> local;
+  auto found = local.find (str);
+  if (found != local.end())
+    return found->second;
+
+  // Keys are views of the owned strings, which never move
+  static std::unordered_map<std::string_view, std::unique_ptr<std::string> > strings;
+  static std::shared_mutex mutex;
+
+  const std::string* out = nullptr;
+  {
+    std::shared_lock<std::shared_mutex> lock (mutex);
+    auto iter = strings.find (str);
+    if (iter != strings.end())
+      out = iter->second.get();
+  }
+
+  if (!out)
+  {
+    std::unique_lock<std::shared_mutex> lock (mutex);
+    auto iter = strings.find (str);
+    if (iter == strings.end())
+    {
+      auto owned = std::make_unique<std::string>(str);
+      out = owned.get();
+      strings.emplace (std::string_view(*out), std::move(owned));
+    }
+    else
+      out = iter->second.get();
+  }
+
+  local.emplace (std::string_view(*out), out);
+  return out;
+}
+
+} // namespace Sosage
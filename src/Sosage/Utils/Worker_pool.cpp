@@ -0,0 +1,94 @@
+/*
+  [src/Sosage/Utils/Worker_pool.cpp]
+  Background threads for loading tasks.
+
+  =====================================================================
+
+  This file is part of SOSAGE.
+
+  SOSAGE is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  SOSAGE is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with SOSAGE.  If not, see <https://www.gnu.org/licenses/>.
+
+  =====================================================================
+
+  Author(s): Simon Giraudot <sosage@ptilouk.net>
+*/
+
+#include <Sosage/Config/platform.h>
+#include <Sosage/Utils/error.h>
+#include <Sosage/Utils/Worker_pool.h>
+
+#include <algorithm>
+
+namespace Sosage
+{
+
+Worker_pool::Worker_pool (std::size_t nb_threads)
+  : m_stop (false)
+{
+  m_threads.reserve (nb_threads);
+  for (std::size_t i = 0; i < nb_threads; ++ i)
+    m_threads.emplace_back ([this]() { work(); });
+}
+
+Worker_pool::~Worker_pool()
+{
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_stop = true;
+  }
+  m_condition.notify_all();
+  for (std::thread& t : m_threads)
+    t.join();
+}
+
+std::size_t Worker_pool::size() const
+{
+  return m_threads.size();
+}
+
+void Worker_pool::work()
+{
+  while (true)
+  {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock (m_mutex);
+      m_condition.wait (lock, [&]() { return m_stop || !m_jobs.empty(); });
+      if (m_stop && m_jobs.empty())
+        return;
+      job = std::move (m_jobs.front());
+      m_jobs.pop_front();
+    }
+    job();
+  }
+}
+
+Worker_pool& workers()
+{
+  static Worker_pool pool ([]() -> std::size_t
+  {
+    // Emscripten is built without thread support
+    if constexpr (Config::emscripten)
+      return 0;
+    std::size_t nb = std::thread::hardware_concurrency();
+    // Leave one core to the main thread
+    nb = (nb > 1 ? nb - 1 : 1);
+    debug << "Using " << std::min (nb, Config::max_worker_threads)
+          << " worker thread(s)" << std::endl;
+    return std::min (nb, Config::max_worker_threads);
+  }());
+  return pool;
+}
+
+} // namespace Sosage
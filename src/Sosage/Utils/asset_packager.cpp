@@ -37,11 +37,18 @@
 
 #include <SDL_image.h>
 
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
+#include <iterator>
 #include <sstream>
+#include <thread>
+#include <unordered_set>
 
 #include <tbb/parallel_for_each.h>
+#include <tbb/parallel_pipeline.h>
 
 namespace Sosage::SCAP
 {
@@ -98,149 +105,256 @@ inline void display_compression (std::size_t before, std::size_t after)
     std::cerr << before << " B  ->  " << after << " B)" << std::endl;
 }
 
-void write_file (std::ofstream& ofile, const std::string& filename)
+// One packaged asset going through the pipeline
+struct Record
 {
-  std::ifstream ifile (filename);
+  std::string abs_path;
+  std::string path; // packaged path
+  std::string extension;
+  bool with_mask = false;
+
+  Buffer input;
+  unsigned short width = 0;
+  unsigned short height = 0;
+  SDL_Surface* surface = nullptr;
+  std::vector<SDL_Surface*> tiles;
+  Bitmap_2 mask;
+
+  std::ostringstream output;
+  std::size_t size_before = 0;
+  std::size_t size_after = 0;
+
+  std::string cache_key;
+  bool cached = false;
+};
+using Record_ptr = std::shared_ptr<Record>;
+
+// Compressed records are cached by hash of input content and of the
+// parameters used to process it, so that unchanged files are simply
+// copied from one build to the next
+std::string cache_key (const Buffer& content, const std::string& parameters)
+{
+  // FNV-1a
+  std::uint64_t hash = 14695981039346656037ull;
+  auto add = [&](const char* data, std::size_t size)
+  {
+    for (std::size_t i = 0; i < size; ++ i)
+    {
+      hash ^= std::uint64_t((unsigned char)(data[i]));
+      hash *= 1099511628211ull;
+    }
+  };
+  add (content.data(), content.size());
+  add (parameters.data(), parameters.size());
+  // Records written with another package format or by another
+  // version of the packager are not reused
+  add (Config::package_index_magic.data(), Config::package_index_magic.size());
+  std::string version = std::to_string(cache_version);
+  add (version.data(), version.size());
+
   std::ostringstream oss;
-  oss << ifile.rdbuf();
-  std::string str = oss.str();
-  Buffer buffer (str.begin(), str.end());
-  std::size_t size_before = buffer.size();
-  package_size_before += size_before;
-
-  binary_write (ofile, buffer.size());
-  Buffer cbuffer = lz4_compress_buffer (buffer.data(), buffer.size());
-  buffer.swap(cbuffer);
-  std::size_t size_after = buffer.size();
-  package_size_after += size_after;
-  display_compression (size_before, size_after);
-
-  binary_write (ofile, buffer.size());
-  binary_write (ofile, buffer);
+  oss << std::hex << std::setw(16) << std::setfill('0') << hash << "_" << content.size();
+  return oss.str();
+}
+
+std::string record_parameters (const Record& record)
+{
+  if (record.extension != "png")
+    return "file";
+  return "png format=" + std::to_string(surface_format)
+    + " split=" + std::to_string(Splitter::max_length)
+    + " map=" + std::to_string(endswith (record.abs_path, "_map.png"))
+    + " mask=" + std::to_string(record.with_mask);
+}
+
+bool read_cache (const std::string& cache_folder, Record& record)
+{
+  if (cache_folder.empty())
+    return false;
+  std::ifstream ifile (cache_folder + "/" + record.cache_key, std::ios::binary);
+  if (!ifile)
+    return false;
+
+  record.size_before = binary_read<std::size_t>(ifile);
+  record.size_after = binary_read<std::size_t>(ifile);
+  record.output << ifile.rdbuf();
+  record.cached = true;
+  return true;
+}
+
+void write_cache (const std::string& cache_folder, const Record& record)
+{
+  if (cache_folder.empty())
+    return;
+
+  // Identical files share the same key: write to a unique temporary
+  // file and rename it, which is atomic
+  std::ostringstream tmp;
+  tmp << cache_folder << "/" << record.cache_key << "." << std::this_thread::get_id() << ".tmp";
+  {
+    std::ofstream ofile (tmp.str(), std::ios::binary);
+    binary_write (ofile, record.size_before);
+    binary_write (ofile, record.size_after);
+    ofile << record.output.str();
+  }
+  std::error_code error;
+  std::filesystem::rename (tmp.str(), cache_folder + "/" + record.cache_key, error);
+  if (error)
+    std::filesystem::remove (tmp.str(), error);
 }
 
-void write_image (std::ofstream& ofile, const std::string& filename, bool is_object)
+// Time spent in each stage, summed over threads
+struct Stage_timer
 {
-  SDL_Surface* input = IMG_Load (filename.c_str());
+  std::atomic<std::size_t> microseconds = 0;
+
+  template <typename Functor>
+  void run (const Functor& functor)
+  {
+    auto start = std::chrono::steady_clock::now();
+    functor();
+    auto end = std::chrono::steady_clock::now();
+    microseconds += std::size_t(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+  }
+
+  double seconds() const { return microseconds / 1e6; }
+};
+
+void decode (Record& record, const std::string& cache_folder)
+{
+  // Graphs are only generated if they were not found in cache
+  if (record.extension == "graph" && read_cache (cache_folder, record))
+    return;
+
+  std::ifstream ifile (record.abs_path, std::ios::binary);
+  record.input.assign (std::istreambuf_iterator<char>(ifile), std::istreambuf_iterator<char>());
+
+  if (record.extension != "graph")
+  {
+    record.cache_key = cache_key (record.input, record_parameters (record));
+    if (read_cache (cache_folder, record))
+    {
+      Buffer().swap (record.input);
+      return;
+    }
+  }
+
+  if (record.extension == "png")
+  {
+    record.surface = IMG_Load_RW (SDL_RWFromConstMem (record.input.data(), int(record.input.size())), 1);
+    check (record.surface != nullptr, "Cannot load image " + record.abs_path);
+    Buffer().swap (record.input);
+  }
+}
+
+void process (Record& record)
+{
+  if (record.cached || record.extension != "png")
+    return;
+
+  SDL_Surface* input = record.surface;
   Third_party::SDL::fix_transparent_borders(input);
   SDL_PixelFormat* format = SDL_AllocFormat(surface_format);
   SDL_Surface *output = SDL_ConvertSurface(input, format, 0);
   SDL_FreeFormat(format);
   SDL_FreeSurface(input);
+  record.width = (unsigned short)(output->w);
+  record.height = (unsigned short)(output->h);
 
-  Bitmap_2 mask;
-  if (is_object)
-    mask = Third_party::SDL::create_mask(output);
-
-  SDL_LockSurface(output);
-  unsigned short width = (unsigned short)(output->w);
-  unsigned short height = (unsigned short)(output->h);
-  unsigned int bpp = (unsigned int)(output->format->BytesPerPixel);
-  SDL_UnlockSurface(output);
-
-  binary_write (ofile, width);
-  binary_write (ofile, height);
-  binary_write (ofile, surface_format);
+  if (record.with_mask)
+    record.mask = Third_party::SDL::create_mask(output);
 
-  std::vector<SDL_Surface*> tiles;
-  if (endswith (filename, "_map.png"))
-  {
-    tiles.push_back(output);
-  }
+  if (endswith (record.abs_path, "_map.png"))
+    record.tiles.push_back(output);
   else
   {
-    tiles = Splitter::split_image(output);
+    record.tiles = Splitter::split_image(output);
     SDL_FreeSurface(output);
-    std::cerr << " -> image splitted into " << tiles.size() << std::endl;
   }
+  record.surface = nullptr;
+}
 
-  std::size_t parallel_size = (is_object ? 2 * tiles.size() : tiles.size());
-  std::vector<std::size_t> index (tiles.size());
+void compress_file (Record& record)
+{
+  record.size_before = record.input.size();
+
+  binary_write (record.output, record.input.size());
+  Codec codec;
+  Buffer cbuffer = compress_buffer (record.input.data(), record.input.size(), codec);
+  Buffer().swap (record.input);
+  record.size_after = cbuffer.size();
+
+  binary_write (record.output, cbuffer.size());
+  binary_write (record.output, codec);
+  binary_write (record.output, cbuffer);
+}
+
+void compress_image (Record& record)
+{
+  unsigned int bpp = (unsigned int)(record.tiles.front()->format->BytesPerPixel);
+
+  binary_write (record.output, record.width);
+  binary_write (record.output, record.height);
+  binary_write (record.output, surface_format);
+
+  std::vector<std::size_t> index (record.tiles.size());
   for (std::size_t i = 0; i < index.size(); ++ i)
     index[i] = i;
-  std::vector<std::size_t> size_before (parallel_size);
-  std::vector<std::size_t> size_after (parallel_size);
-  std::vector<Buffer> buffer (parallel_size);
-
-  // 8min15 100% seq
-  // 5min00 limit 8
-  // 4min17 100% parallel
-  // 4min13 limit 3
+  std::vector<std::size_t> size_before (record.tiles.size());
+  std::vector<std::size_t> size_after (record.tiles.size());
+  std::vector<Buffer> buffer (record.tiles.size());
+  std::vector<Codec> codec (record.tiles.size());
+
   auto compress_images = [&](const std::size_t& idx)
   {
-    SDL_Surface* tile = tiles[idx];
-    std::size_t iidx = (is_object ? idx*2 : idx);
+    SDL_Surface* tile = record.tiles[idx];
     SDL_LockSurface(tile);
     unsigned int size = bpp * tile->w * tile->h;
-    size_before[iidx] = size;
+    size_before[idx] = size;
 
-    buffer[iidx] = lz4_compress_buffer (tile->pixels, size);
+    buffer[idx] = compress_buffer (tile->pixels, size, codec[idx]);
     SDL_UnlockSurface(tile);
-    size_after[iidx] = buffer[iidx].size();
-
-    // Highlight
-    if (is_object)
-    {
-      SDL_Surface* high = SDL_CreateRGBSurfaceWithFormat (0, tile->w, tile->h, 32, surface_format);
-      SDL_FillRect(high, nullptr, SDL_MapRGBA(high->format, Uint8(0), Uint8(0), Uint8(0), Uint8(0)));
-      SDL_BlitSurface (tile, nullptr, high, nullptr);
-
-      Third_party::SDL::Surface_access access (high);
-      for (std::size_t j = 0; j < access.height(); ++ j)
-        for (std::size_t i = 0; i < access.width(); ++ i)
-          access.set(i,j, {255, 255, 255, (unsigned char)(0.5 * access.get(i,j)[3])});
-      access.release();
-
-      SDL_LockSurface(high);
-      size_before[iidx+1] = size;
-      buffer[iidx+1] = lz4_compress_buffer (high->pixels, size);
-      SDL_UnlockSurface(high);
-      size_after[iidx+1] = buffer[iidx].size();
-      SDL_FreeSurface (high);
-    }
+    size_after[idx] = buffer[idx].size();
     SDL_FreeSurface (tile);
   };
 
   std::size_t limit = 3;
-  if (tiles.size() > limit)
+  if (record.tiles.size() > limit)
     tbb::parallel_for_each (index.begin(), index.end(), compress_images);
   else
     std::for_each (index.begin(), index.end(), compress_images);
-
-  std::size_t total_size_before = 0;
-  std::size_t total_size_after = 0;
+  record.tiles.clear();
 
   for (std::size_t i = 0; i < buffer.size(); ++ i)
   {
-    total_size_before += size_before[i];
-    binary_write (ofile, buffer[i].size());
-    binary_write (ofile, buffer[i]);
-    total_size_after += size_after[i];
-
+    record.size_before += size_before[i];
+    binary_write (record.output, buffer[i].size());
+    binary_write (record.output, codec[i]);
+    binary_write (record.output, buffer[i]);
+    record.size_after += size_after[i];
   }
 
-  if (is_object)
+  if (record.with_mask)
   {
-    std::size_t size_before = mask.size();
-    total_size_before += size_before;
-    Buffer buffer = lz4_compress_buffer (mask.data(), size_before);
-    binary_write (ofile, size_before);
-    binary_write (ofile, buffer.size());
-    binary_write (ofile, buffer);
-    std::size_t size_after = buffer.size();
-    total_size_after += size_after;
+    std::size_t size_before = record.mask.size();
+    record.size_before += size_before;
+    Codec codec;
+    Buffer buffer = compress_buffer (record.mask.data(), size_before, codec);
+    binary_write (record.output, size_before);
+    binary_write (record.output, buffer.size());
+    binary_write (record.output, codec);
+    binary_write (record.output, buffer);
+    record.size_after += buffer.size();
+    record.mask = Bitmap_2();
   }
-
-  package_size_before += total_size_before;
-  package_size_after += total_size_after;
-
-  display_compression (total_size_before, total_size_after);
 }
 
-
-void compile_package (const std::string& input_folder, const std::string& output_folder)
+void compile_package (const std::string& input_folder, const std::string& output_folder,
+                      bool deterministic, const std::string& cache_folder)
 {
   std::cerr.precision(3);
+  auto start = std::chrono::steady_clock::now();
+
   // Prepare package
   std::filesystem::create_directory(output_folder + "/data/");
   std::filesystem::create_directory(output_folder + "/resources");
@@ -250,76 +364,216 @@ void compile_package (const std::string& input_folder, const std::string& output
 
   Package_files files = open_packages(output_folder + "/data/");
   Asset_manager::init(root, true);
-
   std::size_t root_size = root.size();
   if (root[root.size() - 1] != '/')
     root_size ++;
 
+  // Directory iteration order is unspecified, sort it to always
+  // produce the same packages from the same data
+  std::vector<std::string> inputs;
   for(const auto& p: std::filesystem::recursive_directory_iterator(root))
+    if (!std::filesystem::is_directory(p))
+      inputs.push_back (p.path().string());
+  if (deterministic)
+    std::sort (inputs.begin(), inputs.end());
+
+  if (!cache_folder.empty())
   {
-    if (std::filesystem::is_directory(p))
-      continue;
-    std::string abs_path = p.path();
-    std::string path = std::string(abs_path.begin() + root_size, abs_path.end());
+    std::filesystem::create_directories (cache_folder);
+    std::cerr << "Using cache " << cache_folder << std::endl;
+  }
 
-    std::string extension = std::string(path.begin() + path.find_last_of('.') + 1, path.end());
-    if (extension == "data")
-      continue;
+  Stage_timer graph_timer, decode_timer, process_timer, compress_timer, write_timer;
+  std::atomic<std::size_t> nb_cached = 0;
 
-    if (contains (path, "_map.png"))
+  // Ground map graphs are independent from each other, build them
+  // all concurrently before writing packages
+  std::vector<std::string> maps;
+  std::copy_if (inputs.begin(), inputs.end(), std::back_inserter(maps),
+                [](const std::string& abs_path) { return contains (abs_path, "_map.png"); });
+
+  std::unordered_map<std::string, std::string> graph_keys;
+  for (const std::string& abs_path : maps)
+    graph_keys.insert (std::make_pair (abs_path, std::string()));
+
+  tbb::parallel_for_each (maps.begin(), maps.end(), [&](const std::string& abs_path)
+  {
+    graph_timer.run([&]
     {
-      std::cerr << "Packaging " << path << " precomputed graph" << std::endl;
+      // Graph only depends on the map image
+      std::ifstream ifile (abs_path, std::ios::binary);
+      Buffer content ((std::istreambuf_iterator<char>(ifile)), std::istreambuf_iterator<char>());
+      std::string& key = graph_keys.at(abs_path);
+      key = cache_key (content, "graph with shortest paths");
+      if (!cache_folder.empty() && std::filesystem::exists (cache_folder + "/" + key))
+        return;
+
+      std::string path = std::string(abs_path.begin() + root_size, abs_path.end());
       std::string abs_map_path = abs_path;
       abs_map_path.resize(abs_map_path.size() - 4);
       abs_map_path += ".graph";
 
-
+      std::cerr << "Packaging " << path << " precomputed graph" << std::endl;
       Component::Ground_map map ("", "", path, 0, 0, []{});
+      map.precompute_shortest_paths();
       map.write(abs_map_path);
+    });
+  });
+
+  // Records of files to package, in output order
+  std::vector<Record_ptr> records;
+  for (const std::string& abs_path : inputs)
+  {
+    std::string path = std::string(abs_path.begin() + root_size, abs_path.end());
+
+    std::string extension = std::string(path.begin() + path.find_last_of('.') + 1, path.end());
+    if (extension == "data")
+      continue;
 
-      std::string map_path = std::string(abs_map_path.begin() + root_size, abs_map_path.end());
-      map_path += ".lz4";
+    // Graphs are packaged along with their maps
+    if (extension == "graph")
+      continue;
 
-      unsigned char path_size = map_path.size();
-      Output_file file = files[package(path)];
-      binary_write (*file, path_size);
-      binary_write (*file, map_path);
-      write_file (*file, abs_map_path);
+    if (contains (path, "_map.png"))
+    {
+      Record_ptr graph = std::make_shared<Record>();
+      graph->abs_path = abs_path;
+      graph->abs_path.resize(graph->abs_path.size() - 4);
+      graph->abs_path += ".graph";
+      graph->path = std::string(graph->abs_path.begin() + root_size, graph->abs_path.end()) + ".lz4";
+      graph->extension = "graph";
+      graph->cache_key = graph_keys[abs_path];
+      records.push_back (graph);
     }
 
+    Record_ptr record = std::make_shared<Record>();
+    record->abs_path = abs_path;
+    record->extension = extension;
     if (extension == "png")
     {
       path.resize(path.size() - 3);
       path += "sdl_surface.lz4";
+      record->with_mask = (contains(path, "images/objects") || contains(path, "images/interface")
+                           || contains(path, "images/inventory") || contains(path, "images/masks"));
     }
-    else
-      path += ".lz4";
-
-    std::cerr << "Packaging " << path << std::endl;
-
-    if (path.size() >= 255)
-      std::cerr << "Warning: path exceeds 255 char limit: " << path << std::endl;
-
-    unsigned char path_size = path.size();
-    Output_file file = files[package(path)];
-    binary_write (*file, path_size);
-    binary_write (*file, path);
-
-    if (extension == "png")
-      write_image (*file, abs_path, contains(path, "images/objects") ||
-                   contains(path, "images/interface") || contains(path, "images/inventory") || contains(path, "images/masks"));
     else
     {
       if (extension != "yaml" && extension != "ogg" && extension != "ttf" && extension != "txt")
         std::cerr << "Warning: unknown extension " << extension << std::endl;
-      write_file (*file, abs_path);
+      path += ".lz4";
     }
+    record->path = path;
+    records.push_back (record);
   }
+
+  // Decode, process and compress files concurrently, write them in
+  // order. Tokens bound the number of files held in memory.
+  std::size_t next = 0;
+  std::size_t max_tokens = 2 * std::max (1u, std::thread::hardware_concurrency());
+  tbb::parallel_pipeline
+    (max_tokens,
+     tbb::make_filter<void, Record_ptr>
+     (tbb::filter_mode::serial_in_order,
+      [&](tbb::flow_control& fc) -> Record_ptr
+      {
+        if (next == records.size())
+        {
+          fc.stop();
+          return Record_ptr();
+        }
+        return records[next ++];
+      })
+     & tbb::make_filter<Record_ptr, Record_ptr>
+     (tbb::filter_mode::parallel,
+      [&](Record_ptr record) -> Record_ptr
+      {
+        decode_timer.run([&] { decode(*record, cache_folder); });
+        return record;
+      })
+     & tbb::make_filter<Record_ptr, Record_ptr>
+     (tbb::filter_mode::parallel,
+      [&](Record_ptr record) -> Record_ptr
+      {
+        process_timer.run([&] { process(*record); });
+        return record;
+      })
+     & tbb::make_filter<Record_ptr, Record_ptr>
+     (tbb::filter_mode::parallel,
+      [&](Record_ptr record) -> Record_ptr
+      {
+        if (record->cached)
+        {
+          ++ nb_cached;
+          return record;
+        }
+        compress_timer.run([&]
+        {
+          if (record->extension == "png")
+            compress_image(*record);
+          else
+            compress_file(*record);
+          write_cache (cache_folder, *record);
+        });
+        return record;
+      })
+     & tbb::make_filter<Record_ptr, void>
+     (tbb::filter_mode::serial_in_order,
+      [&](Record_ptr record)
+      {
+        write_timer.run([&]
+        {
+          std::cerr << "Packaging " << record->path << std::endl;
+          if (record->path.size() >= 255)
+            std::cerr << "Warning: path exceeds 255 char limit: " << record->path << std::endl;
+
+          unsigned char path_size = record->path.size();
+          Output_file file = files[package(record->path)];
+          binary_write (*file, path_size);
+          binary_write (*file, record->path);
+          *file << record->output.rdbuf();
+
+          package_size_before += record->size_before;
+          package_size_after += record->size_after;
+          display_compression (record->size_before, record->size_after);
+        });
+        record.reset();
+      }));
+
   unsigned char zero_size = 0;
   for (auto& f : files)
+  {
     binary_write(*(f.second), zero_size);
+    f.second->close();
+    std::cerr << "Indexing " << f.first << ".data" << std::endl;
+    Asset_manager::append_index (output_folder + "/data/" + f.first + ".data");
+  }
 
-  std::cerr << "All done" << std::endl;
+  auto end = std::chrono::steady_clock::now();
+  std::cerr << "All done in " << std::chrono::duration<double>(end - start).count() << "s" << std::endl;
+  std::cerr << " * graphs: " << graph_timer.seconds() << "s" << std::endl
+            << " * decode: " << decode_timer.seconds() << "s" << std::endl
+            << " * process: " << process_timer.seconds() << "s" << std::endl
+            << " * compress: " << compress_timer.seconds() << "s" << std::endl
+            << " * write: " << write_timer.seconds() << "s" << std::endl
+            << " (stage times are summed over threads)" << std::endl;
+  if (!cache_folder.empty())
+  {
+    std::cerr << nb_cached << "/" << records.size() << " records reused from cache" << std::endl;
+
+    // Prune outdated entries (and temporary files of interrupted builds)
+    std::unordered_set<std::string> used;
+    for (const Record_ptr& r : records)
+      used.insert (r->cache_key);
+    std::size_t nb_pruned = 0;
+    for (const auto& p : std::filesystem::directory_iterator(cache_folder))
+      if (p.is_regular_file() && !used.count (p.path().filename().string()))
+      {
+        std::error_code error;
+        if (std::filesystem::remove (p.path(), error))
+          ++ nb_pruned;
+      }
+    std::cerr << nb_pruned << " outdated records removed from cache" << std::endl;
+  }
   display_compression (package_size_before, package_size_after);
 }
 
@@ -349,10 +603,6 @@ void decompile_package (const std::string& ifolder, std::string folder)
     {
       debug << fname << std::endl;
 
-      // Do not decompile highlights
-      if (contains(fname, ".HL."))
-        continue;
-
       // Do not decompile masks
       if (contains(fname, ".mask."))
         continue;
@@ -405,10 +655,14 @@ void decompile_package (const std::string& ifolder, std::string folder)
       directories_to_create.resize (directories_to_create.find_last_of('/'));
       std::filesystem::create_directories(directories_to_create);
 
+      // Stored assets are read in place from the package and have no
+      // buffer of their own, so always go through read()
       Asset asset = Asset_manager::open(fname);
-      std::ofstream ofile(ofname, std::ios::binary);
-      binary_write (ofile, *asset.buffer());
+      Buffer buffer (asset.size());
+      asset.read (buffer.data(), buffer.size());
       asset.close();
+      std::ofstream ofile(ofname, std::ios::binary);
+      binary_write (ofile, buffer);
     }
   }
 }
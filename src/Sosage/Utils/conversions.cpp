@@ -82,6 +82,33 @@ void capitalize (std::string& str)
     str[0] = toupper(str[0]);
 }
 
+std::vector<unsigned int> utf8_codepoints (const std::string& str)
+{
+  std::vector<unsigned int> out;
+  out.reserve (str.size());
+  std::size_t i = 0;
+  while (i < str.size())
+  {
+    unsigned char c = str[i];
+    std::size_t nb = (c < 0x80 ? 1 :
+                      (c >> 5) == 0x06 ? 2 :
+                      (c >> 4) == 0x0E ? 3 :
+                      (c >> 3) == 0x1E ? 4 : 0);
+    if (nb == 0 || i + nb > str.size())
+    {
+      ++ i;
+      continue;
+    }
+
+    unsigned int codepoint = (nb == 1 ? c : c & (0x7F >> nb));
+    for (std::size_t j = 1; j < nb; ++ j)
+      codepoint = (codepoint << 6) | (static_cast<unsigned char>(str[i + j]) & 0x3F);
+    out.push_back (codepoint);
+    i += nb;
+  }
+  return out;
+}
+
 bool contains (const std::initializer_list<const char*>& list, const std::string& str)
 {
   for (const char* s : list)
@@ -37,7 +37,8 @@
 namespace Sosage
 {
 
-char* dbg_location = nullptr;
+// Each thread keeps its own location, systems may run concurrently
+thread_local char* dbg_location = const_cast<char*>("Unknown location");
 
 #ifdef SOSAGE_DEBUG_BUFFER
 int Debug_buffer::sync()
@@ -155,6 +155,16 @@ Segment::Segment (const Point& source, const Point& target)
   : m_source (source), m_target (target)
 { }
 
+const Point& Segment::source() const
+{
+  return m_source;
+}
+
+const Point& Segment::target() const
+{
+  return m_target;
+}
+
 Vector Segment::to_vector() const
 {
   return Vector(m_source, m_target);